@@ -0,0 +1,148 @@
+// Copyright 2019
+#include "AllocationCounter.h"
+
+#include "HAL/PlatformTLS.h"
+#include "Misc/OutputDevice.h"
+
+FAllocationCounter::~FAllocationCounter()
+{
+	Unregister();
+}
+
+bool FAllocationCounter::AddThread(uint32 threadId)
+{
+	if (NumberOfThreads >= ALLOCATION_COUNTER_MAX_THREADS) return false;
+
+	ThreadIds[NumberOfThreads++] = threadId;
+	return true;
+}
+
+void FAllocationCounter::ClearAndDisableTLSCachesOnCurrentThread()
+{
+	Inner->ClearAndDisableTLSCachesOnCurrentThread();
+}
+
+void FAllocationCounter::DumpAllocatorStats(FOutputDevice& Ar)
+{
+	Inner->DumpAllocatorStats(Ar);
+}
+
+bool FAllocationCounter::Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar)
+{
+	return Inner->Exec(InWorld, Cmd, Ar);
+}
+
+void FAllocationCounter::Free(void* Original)
+{
+	Inner->Free(Original);
+}
+
+void FAllocationCounter::GetAllocatorStats(FGenericMemoryStats& out_Stats)
+{
+	Inner->GetAllocatorStats(out_Stats);
+}
+
+bool FAllocationCounter::GetAllocationSize(void* Original, SIZE_T& SizeOut)
+{
+	return Inner->GetAllocationSize(Original, SizeOut);
+}
+
+const TCHAR* FAllocationCounter::GetDescriptiveName()
+{
+	return Inner->GetDescriptiveName();
+}
+
+void FAllocationCounter::InitializeStatsMetadata()
+{
+	Inner->InitializeStatsMetadata();
+}
+
+bool FAllocationCounter::IsCountedThread() const
+{
+	const uint32 threadId = FPlatformTLS::GetCurrentThreadId();
+	for (auto index = 0; index < NumberOfThreads; index++)
+	{
+		if (ThreadIds[index] == threadId) return true;
+	}
+
+	return false;
+}
+
+bool FAllocationCounter::IsInternallyThreadSafe() const
+{
+	return Inner->IsInternallyThreadSafe();
+}
+
+void* FAllocationCounter::Malloc(SIZE_T Size, uint32 Alignment)
+{
+	if (IsCountedThread()) FPlatformAtomics::InterlockedIncrement(&Count);
+
+	return Inner->Malloc(Size, Alignment);
+}
+
+void FAllocationCounter::OnMallocInitialized()
+{
+	Inner->OnMallocInitialized();
+}
+
+void FAllocationCounter::OnPostFork()
+{
+	Inner->OnPostFork();
+}
+
+void FAllocationCounter::OnPreFork()
+{
+	Inner->OnPreFork();
+}
+
+SIZE_T FAllocationCounter::QuantizeSize(SIZE_T Size, uint32 Alignment)
+{
+	return Inner->QuantizeSize(Size, Alignment);
+}
+
+void* FAllocationCounter::Realloc(void* Original, SIZE_T Size, uint32 Alignment)
+{
+	// the allocator may move a block to any nonzero size, shrinking included, so every one is counted like a
+	// malloc; a realloc to 0 only frees
+	if (Size > 0 && IsCountedThread()) FPlatformAtomics::InterlockedIncrement(&Count);
+
+	return Inner->Realloc(Original, Size, Alignment);
+}
+
+void FAllocationCounter::Register()
+{
+	if (Inner != nullptr) return;
+
+	AddThread(FPlatformTLS::GetCurrentThreadId());
+	Inner = GMalloc;
+	GMalloc = this;
+}
+
+void FAllocationCounter::SetupTLSCachesOnCurrentThread()
+{
+	Inner->SetupTLSCachesOnCurrentThread();
+}
+
+void FAllocationCounter::Trim(bool bTrimThreadCaches)
+{
+	Inner->Trim(bTrimThreadCaches);
+}
+
+void FAllocationCounter::Unregister()
+{
+	// if something has stood in front of this since, calls still come through here, so keep passing them on
+	if (Inner == nullptr || GMalloc != this) return;
+
+	GMalloc = Inner;
+	Inner = nullptr;
+}
+
+void FAllocationCounter::UpdateStats()
+{
+	Inner->UpdateStats();
+}
+
+bool FAllocationCounter::ValidateHeap()
+{
+	return Inner->ValidateHeap();
+}
@@ -0,0 +1,361 @@
+// Copyright 2019
+#include "BoardBatchKernel.h"
+
+#include "ColumnsBoard.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// Compile the code between them for AVX2 whatever the module is built for, so it's only run once the CPU
+// has been checked; MSVC compiles the AVX2 intrinsics anywhere.
+#if defined(__clang__)
+#define BOARD_BATCH_AVX2_BEGIN _Pragma("clang attribute push (__attribute__((target(\"avx2\"))), apply_to = function)")
+#define BOARD_BATCH_AVX2_END _Pragma("clang attribute pop")
+#elif defined(__GNUC__)
+#define BOARD_BATCH_AVX2_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"avx2\")")
+#define BOARD_BATCH_AVX2_END _Pragma("GCC pop_options")
+#else
+#define BOARD_BATCH_AVX2_BEGIN
+#define BOARD_BATCH_AVX2_END
+#endif
+
+namespace BoardBatchScalar
+{
+	// A cell of every board, a byte at a time.
+	struct FOps
+	{
+		struct FVector
+		{
+			uint8 Bytes[BOARD_BATCH_LANES];
+		};
+
+		static constexpr int32 Bytes = BOARD_BATCH_LANES;
+
+		template <typename FunctorType>
+		static FORCEINLINE FVector Map(const FVector& a, const FVector& b, FunctorType&& functor)
+		{
+			FVector result;
+			for (auto index = 0; index < Bytes; index++)
+			{
+				result.Bytes[index] = (uint8)functor(a.Bytes[index], b.Bytes[index]);
+			}
+
+			return result;
+		}
+
+		static FORCEINLINE FVector Load(const uint8* data) { FVector result; FMemory::Memcpy(result.Bytes, data, Bytes); return result; }
+		static FORCEINLINE void Store(uint8* data, const FVector& value) { FMemory::Memcpy(data, value.Bytes, Bytes); }
+		static FORCEINLINE FVector Zero() { return FVector(); }
+		static FORCEINLINE FVector And(const FVector& a, const FVector& b) { return Map(a, b, [](uint8 x, uint8 y) { return x & y; }); }
+		static FORCEINLINE FVector Or(const FVector& a, const FVector& b) { return Map(a, b, [](uint8 x, uint8 y) { return x | y; }); }
+		static FORCEINLINE FVector AndNot(const FVector& a, const FVector& b) { return Map(a, b, [](uint8 x, uint8 y) { return ~x & y; }); }
+		static FORCEINLINE FVector Equal(const FVector& a, const FVector& b) { return Map(a, b, [](uint8 x, uint8 y) { return x == y ? 0xFF : 0; }); }
+		static FORCEINLINE FVector IsEmpty(const FVector& a) { return Map(a, a, [](uint8 x, uint8) { return x == 0 ? 0xFF : 0; }); }
+		static FORCEINLINE FVector Subtract(const FVector& a, const FVector& b) { return Map(a, b, [](uint8 x, uint8 y) { return x - y; }); }
+
+		static FORCEINLINE bool Any(const FVector& a)
+		{
+			uint8 any = 0;
+			for (auto index = 0; index < Bytes; index++)
+			{
+				any |= a.Bytes[index];
+			}
+
+			return any != 0;
+		}
+
+		static FORCEINLINE void AddCounts(const FVector& counts, uint8* outCounts)
+		{
+			for (auto index = 0; index < Bytes; index++)
+			{
+				outCounts[index] += counts.Bytes[index];
+			}
+		}
+	};
+
+	typedef FOps FTailOps;
+
+	const TCHAR* const KernelName = TEXT("scalar");
+
+#include "BoardBatchKernel.inl"
+}
+
+#if PLATFORM_CPU_X86_FAMILY
+
+namespace BoardBatchSse2
+{
+	// A cell of every board a vector.
+	struct FOps
+	{
+		typedef __m128i FVector;
+
+		static constexpr int32 Bytes = 16;
+
+		static FORCEINLINE FVector Load(const uint8* data) { return _mm_loadu_si128((const __m128i*)data); }
+		static FORCEINLINE void Store(uint8* data, FVector value) { _mm_storeu_si128((__m128i*)data, value); }
+		static FORCEINLINE FVector Zero() { return _mm_setzero_si128(); }
+		static FORCEINLINE FVector And(FVector a, FVector b) { return _mm_and_si128(a, b); }
+		static FORCEINLINE FVector Or(FVector a, FVector b) { return _mm_or_si128(a, b); }
+		static FORCEINLINE FVector AndNot(FVector a, FVector b) { return _mm_andnot_si128(a, b); }
+		static FORCEINLINE FVector Equal(FVector a, FVector b) { return _mm_cmpeq_epi8(a, b); }
+		static FORCEINLINE FVector IsEmpty(FVector a) { return _mm_cmpeq_epi8(a, _mm_setzero_si128()); }
+		static FORCEINLINE FVector Subtract(FVector a, FVector b) { return _mm_sub_epi8(a, b); }
+		static FORCEINLINE bool Any(FVector a) { return _mm_movemask_epi8(a) != 0; }
+		static FORCEINLINE void AddCounts(FVector counts, uint8* outCounts) { Store(outCounts, _mm_add_epi8(Load(outCounts), counts)); }
+	};
+
+	typedef FOps FTailOps;
+
+	const TCHAR* const KernelName = TEXT("sse2");
+
+#include "BoardBatchKernel.inl"
+}
+
+BOARD_BATCH_AVX2_BEGIN
+
+namespace BoardBatchAvx2
+{
+	// Two cells of every board a vector; a board with an odd number of columns does its last column with SSE2.
+	struct FOps
+	{
+		typedef __m256i FVector;
+
+		static constexpr int32 Bytes = 32;
+
+		static FORCEINLINE FVector Load(const uint8* data) { return _mm256_loadu_si256((const __m256i*)data); }
+		static FORCEINLINE void Store(uint8* data, FVector value) { _mm256_storeu_si256((__m256i*)data, value); }
+		static FORCEINLINE FVector Zero() { return _mm256_setzero_si256(); }
+		static FORCEINLINE FVector And(FVector a, FVector b) { return _mm256_and_si256(a, b); }
+		static FORCEINLINE FVector Or(FVector a, FVector b) { return _mm256_or_si256(a, b); }
+		static FORCEINLINE FVector AndNot(FVector a, FVector b) { return _mm256_andnot_si256(a, b); }
+		static FORCEINLINE FVector Equal(FVector a, FVector b) { return _mm256_cmpeq_epi8(a, b); }
+		static FORCEINLINE FVector IsEmpty(FVector a) { return _mm256_cmpeq_epi8(a, _mm256_setzero_si256()); }
+		static FORCEINLINE FVector Subtract(FVector a, FVector b) { return _mm256_sub_epi8(a, b); }
+		static FORCEINLINE bool Any(FVector a) { return _mm256_testz_si256(a, a) == 0; }
+
+		static FORCEINLINE void AddCounts(FVector counts, uint8* outCounts)
+		{
+			// the two cells of a vector are the same boards
+			const __m128i sum = _mm_add_epi8(_mm256_castsi256_si128(counts), _mm256_extracti128_si256(counts, 1));
+			_mm_storeu_si128((__m128i*)outCounts, _mm_add_epi8(_mm_loadu_si128((const __m128i*)outCounts), sum));
+		}
+	};
+
+	typedef BoardBatchSse2::FOps FTailOps;
+
+	const TCHAR* const KernelName = TEXT("avx2");
+
+#include "BoardBatchKernel.inl"
+}
+
+BOARD_BATCH_AVX2_END
+
+#endif
+
+#undef BOARD_BATCH_AVX2_BEGIN
+#undef BOARD_BATCH_AVX2_END
+
+namespace
+{
+	// Returns true if the CPU runs AVX2 and the OS saves the 256 bit registers.
+	bool IsAvx2Supported()
+	{
+#if PLATFORM_CPU_X86_FAMILY && defined(_MSC_VER)
+		int32 info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+
+		// OSXSAVE, then the SSE and AVX state enabled in XCR0
+		__cpuid(info, 1);
+		if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6) return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#elif PLATFORM_CPU_X86_FAMILY
+		return __builtin_cpu_supports("avx2") != 0;
+#else
+		return false;
+#endif
+	}
+
+	// Returns the kernels the CPU can run, slowest first; checked once.
+	const TArray<const FBoardBatchKernel*>& GetSupportedKernels()
+	{
+		static const TArray<const FBoardBatchKernel*> kernels = []()
+		{
+			TArray<const FBoardBatchKernel*> supported;
+			supported.Add(&BoardBatchScalar::Kernel);
+
+#if PLATFORM_CPU_X86_FAMILY
+			supported.Add(&BoardBatchSse2::Kernel);
+			if (IsAvx2Supported()) supported.Add(&BoardBatchAvx2::Kernel);
+#endif
+
+			return supported;
+		}();
+
+		return kernels;
+	}
+}
+
+const FBoardBatchKernel& FBoardBatchKernel::Best()
+{
+	return *GetSupportedKernels().Last();
+}
+
+const FBoardBatchKernel* FBoardBatchKernel::Find(const FString& name)
+{
+	for (const FBoardBatchKernel* kernel : GetSupportedKernels())
+	{
+		if (name.Equals(kernel->Name, ESearchCase::IgnoreCase)) return kernel;
+	}
+
+	return nullptr;
+}
+
+bool FBoardBatch::CollapseEmpty()
+{
+	return Kernel->CollapseEmpty(NumberOfColumns, NumberOfRows, Cells.GetData(), Dirty.GetData());
+}
+
+bool FBoardBatch::Fits(int32 numberOfColumns, int32 numberOfRows, int32 numberOfSymbols)
+{
+	return numberOfColumns > 0 && numberOfRows > 0 && numberOfColumns * numberOfRows <= BOARD_BATCH_MAX_CELLS
+		&& numberOfSymbols <= MAX_uint8;
+}
+
+int32 FBoardBatch::Get(int32 lane, int32 row, int32 column) const
+{
+	return Cells[(row * NumberOfColumns + column) * BOARD_BATCH_LANES + lane];
+}
+
+void FBoardBatch::Init(int32 numberOfColumns, int32 numberOfRows, const FBoardBatchKernel* kernel)
+{
+	NumberOfColumns = numberOfColumns;
+	NumberOfRows = numberOfRows;
+	Kernel = kernel != nullptr ? kernel : &FBoardBatchKernel::Best();
+
+	// the runs from the last cells read up to a diagonal step per symbol past the end, and a vector two
+	// cells wide one more cell
+	const int32 numberOfCells = numberOfColumns * numberOfRows;
+	const int32 paddedBytes = (numberOfCells + (GAME_BOARD_MATCH_LENGTH - 1) * (numberOfColumns + 1) + 1) * BOARD_BATCH_LANES;
+
+	Cells.Reset();
+	Cells.SetNumZeroed(paddedBytes);
+	Dirty.Reset();
+	Dirty.SetNumZeroed(paddedBytes);
+	Matches.Reset();
+	Matches.SetNumZeroed(paddedBytes);
+
+	// right, down, down right and down left
+	const int32 rowSteps[4] = { 0, 1, 1, 1 };
+	const int32 columnSteps[4] = { 1, 0, 1, -1 };
+
+	for (auto direction = 0; direction < 4; direction++)
+	{
+		RunSteps[direction] = rowSteps[direction] * numberOfColumns + columnSteps[direction];
+		RunStarts[direction].Reset();
+		RunStarts[direction].SetNumZeroed(paddedBytes);
+
+		for (auto row = 0; row + rowSteps[direction] * (GAME_BOARD_MATCH_LENGTH - 1) < numberOfRows; row++)
+		{
+			for (auto column = 0; column < numberOfColumns; column++)
+			{
+				const int32 lastColumn = column + columnSteps[direction] * (GAME_BOARD_MATCH_LENGTH - 1);
+				if (lastColumn < 0 || lastColumn >= numberOfColumns) continue;
+
+				FMemory::Memset(&RunStarts[direction][(row * numberOfColumns + column) * BOARD_BATCH_LANES], 0xFF, BOARD_BATCH_LANES);
+			}
+		}
+	}
+}
+
+void FBoardBatch::LoadBoard(int32 lane, const FColumnsBoard& board)
+{
+	check(board.GetNumberOfColumns() == NumberOfColumns && board.GetNumberOfRows() == NumberOfRows);
+
+	// a byte every BOARD_BATCH_LANES bytes from the lane's first
+	const int32* cells = board.GetCells().GetData();
+	uint8* laneCells = Cells.GetData() + lane;
+	uint8* laneDirty = Dirty.GetData() + lane;
+
+	for (auto index = 0; index < NumberOfColumns * NumberOfRows; index++)
+	{
+		laneCells[index * BOARD_BATCH_LANES] = (uint8)cells[index];
+		laneDirty[index * BOARD_BATCH_LANES] = 0;
+	}
+
+	for (const FRowColumn& cell : board.GetDirtyCells())
+	{
+		laneDirty[(cell.Row * NumberOfColumns + cell.Column) * BOARD_BATCH_LANES] = 0xFF;
+	}
+}
+
+bool FBoardBatch::RemoveMatches(uint8 (&outRemoved)[BOARD_BATCH_LANES])
+{
+	FMemory::Memzero(outRemoved, sizeof(outRemoved));
+
+	const int32 numberOfCells = NumberOfColumns * NumberOfRows;
+	for (auto direction = 0; direction < 4; direction++)
+	{
+		Kernel->FindRuns(numberOfCells, RunSteps[direction], GAME_BOARD_MATCH_LENGTH, RunStarts[direction].GetData(),
+			Cells.GetData(), Dirty.GetData(), Matches.GetData());
+	}
+
+	// the board clears its dirty cells once they're checked, whether or not anything matched
+	return Kernel->RemoveFlagged(numberOfCells, Cells.GetData(), Dirty.GetData(), Matches.GetData(), outRemoved);
+}
+
+void FBoardBatch::ResolveCascade(int32 (&outJewels)[BOARD_BATCH_LANES], int32 (&outDepth)[BOARD_BATCH_LANES])
+{
+	FMemory::Memzero(outJewels, sizeof(outJewels));
+	FMemory::Memzero(outDepth, sizeof(outDepth));
+
+	// a lane that has settled has nothing dirty, so the steps the others take leave it as it is
+	uint8 removed[BOARD_BATCH_LANES];
+	while (true)
+	{
+		const bool bRemoved = RemoveMatches(removed);
+		const bool bFell = CollapseEmpty();
+		if (!bRemoved && !bFell) break;
+
+		for (auto lane = 0; lane < BOARD_BATCH_LANES; lane++)
+		{
+			if (removed[lane] == 0) continue;
+
+			outJewels[lane] += removed[lane];
+			outDepth[lane]++;
+		}
+	}
+}
+
+void FBoardBatch::Set(int32 lane, int32 row, int32 column, int32 symbol)
+{
+	const int32 index = (row * NumberOfColumns + column) * BOARD_BATCH_LANES + lane;
+	Cells[index] = (uint8)symbol;
+	if (symbol > 0) Dirty[index] = 0xFF;
+}
+
+void FBoardBatch::StoreBoard(int32 lane, FColumnsBoard& board) const
+{
+	check(board.GetNumberOfColumns() == NumberOfColumns && board.GetNumberOfRows() == NumberOfRows);
+
+	const TArray<int32>& cells = board.GetCells();
+	for (auto index = 0; index < cells.Num(); index++)
+	{
+		const int32 symbol = Cells[index * BOARD_BATCH_LANES + lane];
+		if (cells[index] != symbol) board.Set(index / NumberOfColumns, index % NumberOfColumns, symbol);
+	}
+
+	// set marks every placed symbol dirty; only the lane's dirty cells with a symbol in them matter
+	board.ClearDirty();
+	for (auto index = 0; index < cells.Num(); index++)
+	{
+		const int32 laneIndex = index * BOARD_BATCH_LANES + lane;
+		if (Dirty[laneIndex] != 0 && Cells[laneIndex] != 0) board.MarkDirty(index / NumberOfColumns, index % NumberOfColumns);
+	}
+}
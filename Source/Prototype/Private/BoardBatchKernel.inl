@@ -0,0 +1,114 @@
+// Copyright 2019
+
+// The batch kernel loops, written once against the vector operations of an instruction set. Included by
+// BoardBatchKernel.cpp inside one namespace per instruction set, which first defines FOps, and FTailOps for
+// an odd column left over by vectors two cells wide. Each gives FVector, Bytes (a multiple of a cell's
+// BOARD_BATCH_LANES bytes) and Load, Store, And, Or, AndNot (~a & b), Equal, IsEmpty (0xFF where 0), Zero,
+// Any, Subtract and AddCounts (adds the byte lanes to a cell's worth of counts).
+
+// Drop the symbols of one vector's worth of columns; returns true if any fell.
+template <typename OpsType>
+FORCEINLINE bool CollapseSlice(int32 numberOfRows, int32 rowBytes, uint8* cells, uint8* dirty)
+{
+	typedef typename OpsType::FVector FVector;
+	bool bFell = false;
+
+	// every sweep down the columns carries each symbol with a gap below it down to the next symbol, so a
+	// stack of symbols over a gap settles in one sweep per symbol
+	while (true)
+	{
+		FVector moved = OpsType::Zero();
+		for (auto row = 0; row < numberOfRows - 1; row++)
+		{
+			uint8* upper = cells + row * rowBytes;
+			uint8* lower = upper + rowBytes;
+			uint8* lowerDirty = dirty + (row + 1) * rowBytes;
+
+			const FVector upperCells = OpsType::Load(upper);
+			const FVector lowerCells = OpsType::Load(lower);
+			const FVector move = OpsType::AndNot(OpsType::IsEmpty(upperCells), OpsType::IsEmpty(lowerCells));
+
+			OpsType::Store(lower, OpsType::Or(lowerCells, OpsType::And(upperCells, move)));
+			OpsType::Store(upper, OpsType::AndNot(move, upperCells));
+			OpsType::Store(lowerDirty, OpsType::Or(OpsType::Load(lowerDirty), move));
+			moved = OpsType::Or(moved, move);
+		}
+
+		if (!OpsType::Any(moved)) return bFell;
+
+		bFell = true;
+	}
+}
+
+bool CollapseEmpty(int32 numberOfColumns, int32 numberOfRows, uint8* cells, uint8* dirty)
+{
+	const int32 rowBytes = numberOfColumns * BOARD_BATCH_LANES;
+	bool bFell = false;
+
+	int32 offset = 0;
+	for (; offset + FOps::Bytes <= rowBytes; offset += FOps::Bytes)
+	{
+		bFell |= CollapseSlice<FOps>(numberOfRows, rowBytes, cells + offset, dirty + offset);
+	}
+
+	if (offset < rowBytes)
+	{
+		bFell |= CollapseSlice<FTailOps>(numberOfRows, rowBytes, cells + offset, dirty + offset);
+	}
+
+	return bFell;
+}
+
+void FindRuns(int32 numberOfCells, int32 step, int32 matchLength, const uint8* runStarts, const uint8* cells, const uint8* dirty, uint8* outMatches)
+{
+	typedef FOps::FVector FVector;
+	const int32 stepBytes = step * BOARD_BATCH_LANES;
+
+	for (auto offset = 0; offset < numberOfCells * BOARD_BATCH_LANES; offset += FOps::Bytes)
+	{
+		const FVector first = FOps::Load(cells + offset);
+		FVector run = FOps::AndNot(FOps::IsEmpty(first), FOps::Load(runStarts + offset));
+		FVector runDirty = FOps::Load(dirty + offset);
+
+		for (auto index = 1; index < matchLength; index++)
+		{
+			run = FOps::And(run, FOps::Equal(first, FOps::Load(cells + offset + index * stepBytes)));
+			runDirty = FOps::Or(runDirty, FOps::Load(dirty + offset + index * stepBytes));
+		}
+
+		run = FOps::And(run, runDirty);
+		if (!FOps::Any(run)) continue;
+
+		for (auto index = 0; index < matchLength; index++)
+		{
+			uint8* matches = outMatches + offset + index * stepBytes;
+			FOps::Store(matches, FOps::Or(FOps::Load(matches), run));
+		}
+	}
+}
+
+bool RemoveFlagged(int32 numberOfCells, uint8* cells, uint8* dirty, uint8* matches, uint8* outRemoved)
+{
+	typedef FOps::FVector FVector;
+
+	// a flag is 0xFF, so subtracting it counts one
+	FVector counts = FOps::Zero();
+	FVector removed = FOps::Zero();
+
+	for (auto offset = 0; offset < numberOfCells * BOARD_BATCH_LANES; offset += FOps::Bytes)
+	{
+		const FVector match = FOps::Load(matches + offset);
+		FOps::Store(cells + offset, FOps::AndNot(match, FOps::Load(cells + offset)));
+		FOps::Store(dirty + offset, FOps::Zero());
+		FOps::Store(matches + offset, FOps::Zero());
+
+		counts = FOps::Subtract(counts, match);
+		removed = FOps::Or(removed, match);
+	}
+
+	FOps::AddCounts(counts, outRemoved);
+	return FOps::Any(removed);
+}
+
+// The kernel functions of the instruction set, for the table in BoardBatchKernel.cpp.
+const FBoardBatchKernel Kernel = { KernelName, &CollapseEmpty, &FindRuns, &RemoveFlagged };
@@ -0,0 +1,64 @@
+// Copyright 2019
+#include "BoardBitboard.h"
+
+bool FBoardBitboard::Fits(int32 numberOfColumns, int32 numberOfRows, int32 numberOfSymbols)
+{
+	return numberOfColumns > 0 && numberOfRows > 0
+		&& (numberOfColumns + 1) * numberOfRows <= 128
+		&& numberOfSymbols <= BITBOARD_MAX_SYMBOLS;
+}
+
+FBitboard128 FBoardBitboard::FindMatches(const FBitboard128& dirty) const
+{
+	// shift distances for right, down, down right and down left runs
+	const int32 directions[4] = { 1, Stride, Stride + 1, Stride - 1 };
+
+	FBitboard128 matches;
+
+	for (auto symbol = 0; symbol < BITBOARD_MAX_SYMBOLS; symbol++)
+	{
+		const FBitboard128& cells = Symbols[symbol];
+		if (cells.CountBits() < 3) continue;
+
+		for (auto direction = 0; direction < 4; direction++)
+		{
+			const int32 shift = directions[direction];
+
+			// mark the first cell of every run of 3 with a dirty cell in it, then spread it over the other two
+			const FBitboard128 starts = cells & (cells >> shift) & (cells >> (shift * 2))
+				& (dirty | (dirty >> shift) | (dirty >> (shift * 2)));
+			if (starts.IsEmpty()) continue;
+
+			matches |= starts | (starts << shift) | (starts << (shift * 2));
+		}
+	}
+
+	return matches;
+}
+
+void FBoardBitboard::MaskToLocations(FBitboard128 mask, TArray<FRowColumn>& outLocations) const
+{
+	while (!mask.IsEmpty())
+	{
+		const int32 bit = mask.PopLowestBit();
+		outLocations.Add(FRowColumn(bit / Stride, bit % Stride));
+	}
+}
+
+void FBoardBitboard::Reset(int32 numberOfColumns, int32 numberOfRows)
+{
+	Stride = numberOfColumns + 1;
+
+	for (auto symbol = 0; symbol < BITBOARD_MAX_SYMBOLS; symbol++)
+	{
+		Symbols[symbol] = FBitboard128();
+	}
+}
+
+void FBoardBitboard::Set(int32 row, int32 column, int32 oldSymbol, int32 newSymbol)
+{
+	const int32 bit = GetBit(row, column);
+
+	if (oldSymbol > 0 && oldSymbol <= BITBOARD_MAX_SYMBOLS) Symbols[oldSymbol - 1].ClearBit(bit);
+	if (newSymbol > 0 && newSymbol <= BITBOARD_MAX_SYMBOLS) Symbols[newSymbol - 1].SetBit(bit);
+}
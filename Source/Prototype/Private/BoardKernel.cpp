@@ -0,0 +1,114 @@
+// Copyright 2019
+#include "BoardKernel.h"
+
+// Makes the kernel functions of a specialization, for the table below.
+#define BOARD_KERNEL(Cols, Rows, MatchLen) \
+	{ Cols, Rows, MatchLen, { &TBoardKernel<Cols, Rows, MatchLen>::CollapseEmpty, &TBoardKernel<Cols, Rows, MatchLen>::FindMatches } }
+
+// Makes a specialization of the collapse alone, for boards whose matches the bitboard finds.
+#define BOARD_KERNEL_COLLAPSE(Cols, Rows, MatchLen) \
+	{ Cols, Rows, MatchLen, { &TBoardKernel<Cols, Rows, MatchLen>::CollapseEmpty, nullptr } }
+
+namespace
+{
+	// A specialized kernel and the board it's for.
+	struct FBoardKernelEntry
+	{
+		int32 NumberOfColumns;
+		int32 NumberOfRows;
+		int32 MatchLength;
+		FBoardKernel Kernel;
+	};
+
+	// Every board size with a specialized kernel.
+	const FBoardKernelEntry BoardKernels[] =
+	{
+		BOARD_KERNEL_COLLAPSE(6, 13, 3),
+		BOARD_KERNEL_COLLAPSE(8, 13, 3),
+		BOARD_KERNEL(12, 13, 3),
+	};
+}
+
+#undef BOARD_KERNEL
+#undef BOARD_KERNEL_COLLAPSE
+
+void FBoardKernel::CollapseEmptyRuntime(int32 numberOfColumns, int32 numberOfRows, int32* cells, TArray<FSymbolFall>& outFalls)
+{
+	for (auto column = 0; column < numberOfColumns; column++)
+	{
+		int32 destinationRow = numberOfRows - 1;
+
+		for (auto row = numberOfRows - 1; row >= 0; row--)
+		{
+			const int32 symbol = cells[row * numberOfColumns + column];
+			if (symbol == 0) continue;
+
+			if (row != destinationRow)
+			{
+				cells[destinationRow * numberOfColumns + column] = symbol;
+				cells[row * numberOfColumns + column] = 0;
+				outFalls.Add(FSymbolFall(column, row, destinationRow));
+			}
+
+			destinationRow--;
+		}
+	}
+}
+
+const FBoardKernel* FBoardKernel::Find(int32 numberOfColumns, int32 numberOfRows, int32 matchLength)
+{
+	for (const FBoardKernelEntry& entry : BoardKernels)
+	{
+		if (entry.NumberOfColumns == numberOfColumns && entry.NumberOfRows == numberOfRows && entry.MatchLength == matchLength)
+		{
+			return &entry.Kernel;
+		}
+	}
+
+	return nullptr;
+}
+
+void FBoardKernel::FindMatchesRuntime(int32 numberOfColumns, int32 numberOfRows, int32 matchLength, const int32* cells,
+	const FRowColumn* dirtyCells, int32 numberOfDirtyCells, uint32* matchBits, TArray<FRowColumn>& outLocations)
+{
+	// right, down, down right and down left
+	const int32 rowSteps[4] = { 0, 1, 1, 1 };
+	const int32 columnSteps[4] = { 1, 0, 1, -1 };
+
+	for (auto dirtyIndex = 0; dirtyIndex < numberOfDirtyCells; dirtyIndex++)
+	{
+		const int32 row = dirtyCells[dirtyIndex].Row;
+		const int32 column = dirtyCells[dirtyIndex].Column;
+		const int32 symbol = cells[row * numberOfColumns + column];
+		if (symbol == 0) continue;
+
+		for (auto direction = 0; direction < 4; direction++)
+		{
+			const int32 step = rowSteps[direction] * numberOfColumns + columnSteps[direction];
+
+			// every run along the line with the dirty cell in it
+			for (auto offset = 0; offset < matchLength; offset++)
+			{
+				const int32 firstRow = row - rowSteps[direction] * offset;
+				const int32 firstColumn = column - columnSteps[direction] * offset;
+				const int32 lastColumn = firstColumn + columnSteps[direction] * (matchLength - 1);
+				if (firstRow < 0 || firstRow + rowSteps[direction] * (matchLength - 1) >= numberOfRows
+					|| FMath::Min(firstColumn, lastColumn) < 0 || FMath::Max(firstColumn, lastColumn) >= numberOfColumns) continue;
+
+				const int32 start = firstRow * numberOfColumns + firstColumn;
+				bool bMatch = true;
+				for (auto index = 0; index < matchLength && bMatch; index++)
+				{
+					bMatch = cells[start + index * step] == symbol;
+				}
+
+				if (!bMatch) continue;
+
+				for (auto index = 0; index < matchLength; index++)
+				{
+					BoardKernelAddMatch(matchBits, numberOfColumns, start + index * step, outLocations);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,643 @@
+// Copyright 2019
+#include "ColumnsBenchmarkCommandlet.h"
+
+#include "AllocationCounter.h"
+#include "BoardBatchKernel.h"
+#include "ColumnsCascade.h"
+#include "ColumnsEnvironment.h"
+#include "ColumnsGame.h"
+#include "ColumnsPolicy.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Prototype.h"
+
+// The least number of removal steps a board needs to go in the long chains corpus.
+constexpr int32 COLUMNS_BENCHMARK_MIN_CHAIN_DEPTH = 3;
+
+// Moves each game plays before the move benchmark counts, so its arrays have grown to their steady state.
+constexpr int32 COLUMNS_BENCHMARK_WARM_UP_MOVES = 32;
+
+// A set of board states to run each benchmark on.
+struct FColumnsBenchmarkCorpus
+{
+	// The name of the corpus in the results.
+	FString Name;
+
+	// The boards, with the cells changed since their last match check still dirty.
+	TArray<FColumnsBoard> Boards;
+
+	// The first row construct fills for boards like these; INDEX_NONE if they aren't made by construct.
+	int32 RowToStartRandomSymbols = INDEX_NONE;
+};
+
+// One operation to time; returns the number of operations done on the board, adding anything it finds to the checksum.
+typedef int32 (*FColumnsBenchmarkFunction)(FColumnsBoard& board, FColumnsRandom& random, int32 rowToStartRandomSymbols, int64& checksum);
+
+// A named operation, and how to get a corpus board ready for it.
+struct FColumnsBenchmark
+{
+	// The name of the benchmark in the results.
+	const TCHAR* Name;
+
+	// The operation to time.
+	FColumnsBenchmarkFunction Function;
+
+	// Change a copy of each corpus board before timing; nullptr to use the boards as they are.
+	void (*Prepare)(FColumnsBoard& board);
+
+	// Whether the operation changes the board, so every round needs fresh copies.
+	bool bChangesBoard;
+
+	// Whether the operation only makes sense for corpora made by construct.
+	bool bNeedsConstruct;
+};
+
+namespace
+{
+	// The removed cells and symbol falls of the operation being timed, reused like the game board reuses its own.
+	TArray<FRowColumn> RemovedCells;
+	TArray<FSymbolFall> SymbolFalls;
+
+	// The cascade being timed, reused the same way.
+	FColumnsCascade Cascade;
+
+	// Resolve the whole cascade in one call, as the game does after a trinity lands; returns the number of
+	// removal steps.
+	int32 ResolveCascade(FColumnsBoard& board, int64& checksum)
+	{
+		const int32 depth = Cascade.Resolve(board);
+
+		for (auto index = 0; index < Cascade.GetNumberOfSteps(); index++)
+		{
+			checksum += Cascade.GetStep(index).NumberOfRemoved + Cascade.GetStep(index).NumberOfFalls;
+		}
+
+		return depth;
+	}
+
+	int32 BenchmarkCascade(FColumnsBoard& board, FColumnsRandom& random, int32 rowToStartRandomSymbols, int64& checksum)
+	{
+		checksum += ResolveCascade(board, checksum);
+		return 1;
+	}
+
+	int32 BenchmarkCheckForAdjacentThree(FColumnsBoard& board, FColumnsRandom& random, int32 rowToStartRandomSymbols, int64& checksum)
+	{
+		for (auto row = 0; row < board.GetNumberOfRows(); row++)
+		{
+			for (auto column = 0; column < board.GetNumberOfColumns(); column++)
+			{
+				checksum += (int64)board.CheckForAdjacentThree(row, column);
+			}
+		}
+
+		return board.GetNumberOfRows() * board.GetNumberOfColumns();
+	}
+
+	int32 BenchmarkCollapseEmpty(FColumnsBoard& board, FColumnsRandom& random, int32 rowToStartRandomSymbols, int64& checksum)
+	{
+		board.CollapseEmpty(SymbolFalls);
+		checksum += SymbolFalls.Num();
+		return 1;
+	}
+
+	int32 BenchmarkConstruct(FColumnsBoard& board, FColumnsRandom& random, int32 rowToStartRandomSymbols, int64& checksum)
+	{
+		board.Construct(rowToStartRandomSymbols, random);
+		checksum += (int64)board.GetHash();
+		return 1;
+	}
+
+	int32 BenchmarkRemoveMatches(FColumnsBoard& board, FColumnsRandom& random, int32 rowToStartRandomSymbols, int64& checksum)
+	{
+		board.RemoveMatches(RemovedCells);
+		checksum += RemovedCells.Num();
+		return 1;
+	}
+
+	// Clear matches and then a regular pattern of cells, leaving gaps for collapse to close.
+	void PrepareCollapseEmpty(FColumnsBoard& board)
+	{
+		board.RemoveMatches(RemovedCells);
+
+		for (auto row = 0; row < board.GetNumberOfRows(); row++)
+		{
+			for (auto column = 0; column < board.GetNumberOfColumns(); column++)
+			{
+				if ((row * 7 + column * 3) % 4 == 0) board.Set(row, column, 0);
+			}
+		}
+	}
+
+	// Drop the trinity straight down the column with the most room that it can reach, shuffled at random,
+	// so games last long enough to reach a steady state without a search allocating along the way.
+	void DropInLowestColumn(FColumnsGame& game, FColumnsRandom& random)
+	{
+		const FColumnsBoard& board = game.GetBoard();
+
+		int32 bestColumn = game.GetLocationX();
+		int32 bestRoom = INDEX_NONE;
+		for (auto column = 0; column < board.GetNumberOfColumns(); column++)
+		{
+			int32 room = 0;
+			while (room < board.GetNumberOfRows() && board.Get(room, column) == 0) room++;
+
+			if (room > bestRoom || (room == bestRoom && random.RandRange(0, 1) == 0))
+			{
+				bestColumn = column;
+				bestRoom = room;
+			}
+		}
+
+		const int32 shuffleDowns = random.RandRange(0, PAWN_SIZE - 1);
+		if (!game.DropPiece(bestColumn, shuffleDowns)) game.DropPiece(game.GetLocationX(), shuffleDowns);
+	}
+
+	// Build the corpora for a board size; every corpus comes from its own seed, so it's the same on every run.
+	TArray<FColumnsBenchmarkCorpus> MakeCorpora(int32 numberOfColumns, int32 numberOfRows, int32 numberOfSymbols, int32 numberOfBoards)
+	{
+		TArray<FColumnsBenchmarkCorpus> corpora;
+
+		// a few rows of symbols at the bottom, as at the start of an early level
+		FColumnsBenchmarkCorpus& sparse = corpora.AddDefaulted_GetRef();
+		sparse.Name = TEXT("sparse");
+		sparse.RowToStartRandomSymbols = numberOfRows - 3;
+
+		// filled up to the rows the trinity needs to enter
+		FColumnsBenchmarkCorpus& dense = corpora.AddDefaulted_GetRef();
+		dense.Name = TEXT("dense");
+		dense.RowToStartRandomSymbols = FColumnsBoard::GetRowToStartRandomSymbols(numberOfRows, numberOfRows);
+
+		const int32 denseRowToStartRandomSymbols = dense.RowToStartRandomSymbols;
+
+		FColumnsRandom random(1);
+		for (FColumnsBenchmarkCorpus& corpus : corpora)
+		{
+			for (auto index = 0; index < numberOfBoards; index++)
+			{
+				FColumnsBoard& board = corpus.Boards.AddDefaulted_GetRef();
+				board.Init(numberOfColumns, numberOfRows, numberOfSymbols);
+				board.Construct(corpus.RowToStartRandomSymbols, random);
+			}
+		}
+
+		// the bottom half all one symbol, so every cell is in a run in all four directions
+		FColumnsBenchmarkCorpus& multiDirection = corpora.AddDefaulted_GetRef();
+		multiDirection.Name = TEXT("multidirection");
+		for (auto index = 0; index < numberOfBoards; index++)
+		{
+			FColumnsBoard& board = multiDirection.Boards.AddDefaulted_GetRef();
+			board.Init(numberOfColumns, numberOfRows, numberOfSymbols);
+			for (auto row = numberOfRows / 2; row < numberOfRows; row++)
+			{
+				for (auto column = 0; column < numberOfColumns; column++)
+				{
+					board.Set(row, column, 1 + index % numberOfSymbols);
+				}
+			}
+		}
+
+		// dense boards with one symbol taken out, kept if they cascade for a while once the column drops
+		FColumnsBenchmarkCorpus& chains = corpora.AddDefaulted_GetRef();
+		chains.Name = TEXT("chains");
+		FColumnsRandom chainRandom(2);
+		for (auto attempt = 0; attempt < numberOfBoards * 1000 && chains.Boards.Num() < numberOfBoards; attempt++)
+		{
+			FColumnsBoard board;
+			board.Init(numberOfColumns, numberOfRows, numberOfSymbols);
+			board.Construct(denseRowToStartRandomSymbols, chainRandom);
+
+			int64 checksum = 0;
+			ResolveCascade(board, checksum);
+
+			board.Set(chainRandom.RandRange(denseRowToStartRandomSymbols, numberOfRows - 1), chainRandom.RandRange(0, numberOfColumns - 1), 0);
+			board.CollapseEmpty(SymbolFalls);
+
+			FColumnsBoard trial = board;
+			if (ResolveCascade(trial, checksum) >= COLUMNS_BENCHMARK_MIN_CHAIN_DEPTH) chains.Boards.Add(board);
+		}
+
+		return corpora;
+	}
+}
+
+UColumnsBenchmarkCommandlet::UColumnsBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UColumnsBenchmarkCommandlet::Main(const FString& Params)
+{
+	int32 numberOfBoards = 64;
+	int32 rounds = 200;
+	int32 numberOfColumns = GAME_BOARD_NUMBER_OF_COLUMNS;
+	int32 numberOfRows = GAME_BOARD_NUMBER_OF_ROWS;
+	int32 numberOfSymbols = GAME_BOARD_NUMBER_OF_SYMBOLS;
+	int32 numberOfThreads = 0;
+	FString filter;
+	FString label = TEXT("none");
+	FString outputPath = FPaths::ProjectSavedDir() / TEXT("ColumnsBenchmark.csv");
+
+	FParse::Value(*Params, TEXT("boards="), numberOfBoards);
+	FParse::Value(*Params, TEXT("rounds="), rounds);
+	FParse::Value(*Params, TEXT("columns="), numberOfColumns);
+	FParse::Value(*Params, TEXT("rows="), numberOfRows);
+	FParse::Value(*Params, TEXT("symbols="), numberOfSymbols);
+	FParse::Value(*Params, TEXT("threads="), numberOfThreads);
+	FParse::Value(*Params, TEXT("filter="), filter);
+	FParse::Value(*Params, TEXT("label="), label);
+	FParse::Value(*Params, TEXT("output="), outputPath);
+
+	if (numberOfBoards <= 0 || rounds <= 0 || numberOfColumns <= 0 || numberOfRows <= PAWN_SIZE || numberOfSymbols <= 0)
+	{
+		UE_LOG(LogColumns, Error, TEXT("Nothing to benchmark; check -boards, -rounds, -columns, -rows and -symbols."));
+		return 1;
+	}
+
+	const FColumnsBenchmark benchmarks[] =
+	{
+		{ TEXT("RemoveMatches"), &BenchmarkRemoveMatches, nullptr, true, false },
+		{ TEXT("CollapseEmpty"), &BenchmarkCollapseEmpty, &PrepareCollapseEmpty, true, false },
+		{ TEXT("CheckForAdjacentThree"), &BenchmarkCheckForAdjacentThree, nullptr, false, false },
+		{ TEXT("Construct"), &BenchmarkConstruct, nullptr, true, true },
+		{ TEXT("Cascade"), &BenchmarkCascade, nullptr, true, false },
+	};
+
+	const TArray<FColumnsBenchmarkCorpus> corpora = MakeCorpora(numberOfColumns, numberOfRows, numberOfSymbols, numberOfBoards);
+
+	FString csv;
+	if (!FPaths::FileExists(outputPath))
+	{
+		csv += TEXT("Label,Benchmark,Corpus,Columns,Rows,Symbols,Boards,Operations,NsPerOp,AllocationsPerOp\n");
+	}
+
+	// only the timed operations are counted, never the copies made for them
+	FAllocationCounter allocationCounter;
+	allocationCounter.Register();
+
+	int64 checksum = 0;
+	for (const FColumnsBenchmark& benchmark : benchmarks)
+	{
+		if (!filter.IsEmpty() && !FString(benchmark.Name).Contains(filter)) continue;
+
+		for (const FColumnsBenchmarkCorpus& corpus : corpora)
+		{
+			if (corpus.Boards.Num() == 0 || (benchmark.bNeedsConstruct && corpus.RowToStartRandomSymbols == INDEX_NONE)) continue;
+
+			TArray<FColumnsBoard> prepared = corpus.Boards;
+			if (benchmark.Prepare != nullptr)
+			{
+				for (FColumnsBoard& board : prepared)
+				{
+					benchmark.Prepare(board);
+				}
+			}
+
+			FColumnsRandom random(3);
+			TArray<FColumnsBoard> boards = prepared;
+			int64 operations = 0;
+			int64 allocations = 0;
+			double seconds = 0.0;
+
+			for (auto round = 0; round < rounds; round++)
+			{
+				if (benchmark.bChangesBoard && round > 0) boards = prepared;
+
+				const int64 allocationsBefore = allocationCounter.GetCount();
+				const double startSeconds = FPlatformTime::Seconds();
+
+				for (FColumnsBoard& board : boards)
+				{
+					operations += benchmark.Function(board, random, corpus.RowToStartRandomSymbols, checksum);
+				}
+
+				seconds += FPlatformTime::Seconds() - startSeconds;
+				allocations += allocationCounter.GetCount() - allocationsBefore;
+			}
+
+			const double nsPerOp = seconds * 1.0e9 / operations;
+			const double allocationsPerOp = (double)allocations / operations;
+
+			UE_LOG(LogColumns, Display, TEXT("%-22s %-15s %10.1f ns/op %8.2f allocs/op (%lld ops)"),
+				benchmark.Name, *corpus.Name, nsPerOp, allocationsPerOp, operations);
+
+			csv += FString::Printf(TEXT("%s,%s,%s,%d,%d,%d,%d,%lld,%f,%f\n"), *label, benchmark.Name, *corpus.Name,
+				numberOfColumns, numberOfRows, numberOfSymbols, corpus.Boards.Num(), operations, nsPerOp, allocationsPerOp);
+		}
+	}
+
+	// the cascade on batches of boards, with each batch kernel the CPU runs; loading and storing the boards
+	// is timed too, as a simulation has to do both, and every result is checked against the board's own
+	bool bBatchMismatch = false;
+	const TCHAR* batchKernelNames[] = { TEXT("scalar"), TEXT("sse2"), TEXT("avx2") };
+	for (const TCHAR* kernelName : batchKernelNames)
+	{
+		const FBoardBatchKernel* kernel = FBoardBatchKernel::Find(kernelName);
+		const FString benchmarkName = FString::Printf(TEXT("BatchCascade.%s"), kernelName);
+		if (kernel == nullptr || !FBoardBatch::Fits(numberOfColumns, numberOfRows, numberOfSymbols)) continue;
+		if (!filter.IsEmpty() && !benchmarkName.Contains(filter)) continue;
+
+		FBoardBatch batch;
+		batch.Init(numberOfColumns, numberOfRows, kernel);
+
+		for (const FColumnsBenchmarkCorpus& corpus : corpora)
+		{
+			if (corpus.Boards.Num() == 0) continue;
+
+			TArray<FColumnsBoard> expected = corpus.Boards;
+			for (FColumnsBoard& board : expected)
+			{
+				int64 expectedChecksum = 0;
+				ResolveCascade(board, expectedChecksum);
+			}
+
+			TArray<FColumnsBoard> boards = corpus.Boards;
+			int32 jewels[BOARD_BATCH_LANES];
+			int32 depths[BOARD_BATCH_LANES];
+			int64 operations = 0;
+			int64 allocations = 0;
+			double seconds = 0.0;
+
+			for (auto round = 0; round < rounds; round++)
+			{
+				if (round > 0) boards = corpus.Boards;
+
+				const int64 allocationsBefore = allocationCounter.GetCount();
+				const double startSeconds = FPlatformTime::Seconds();
+
+				// lanes left over from the last batch have settled, so they sit out the cascade unchanged
+				for (auto first = 0; first < boards.Num(); first += BOARD_BATCH_LANES)
+				{
+					const int32 lanes = FMath::Min(BOARD_BATCH_LANES, boards.Num() - first);
+					for (auto lane = 0; lane < lanes; lane++)
+					{
+						batch.LoadBoard(lane, boards[first + lane]);
+					}
+
+					batch.ResolveCascade(jewels, depths);
+
+					for (auto lane = 0; lane < lanes; lane++)
+					{
+						batch.StoreBoard(lane, boards[first + lane]);
+						checksum += jewels[lane] + depths[lane];
+					}
+
+					operations += lanes;
+				}
+
+				seconds += FPlatformTime::Seconds() - startSeconds;
+				allocations += allocationCounter.GetCount() - allocationsBefore;
+			}
+
+			for (auto index = 0; index < boards.Num(); index++)
+			{
+				if (boards[index].GetHash() != expected[index].GetHash()) bBatchMismatch = true;
+			}
+
+			const double nsPerOp = seconds * 1.0e9 / operations;
+			const double allocationsPerOp = (double)allocations / operations;
+
+			UE_LOG(LogColumns, Display, TEXT("%-22s %-15s %10.1f ns/op %8.2f allocs/op (%lld ops)"),
+				*benchmarkName, *corpus.Name, nsPerOp, allocationsPerOp, operations);
+
+			csv += FString::Printf(TEXT("%s,%s,%s,%d,%d,%d,%d,%lld,%f,%f\n"), *label, *benchmarkName, *corpus.Name,
+				numberOfColumns, numberOfRows, numberOfSymbols, corpus.Boards.Num(), operations, nsPerOp, allocationsPerOp);
+		}
+	}
+
+	// whole moves on headless games: landing, the cascade and the next trinity; the game over restarts aren't counted
+	int64 moveAllocations = 0;
+	if (filter.IsEmpty() || FString(TEXT("Move")).Contains(filter))
+	{
+		FColumnsGameSettings settings;
+		settings.NumberOfColumns = numberOfColumns;
+		settings.NumberOfRows = numberOfRows;
+		settings.NumberOfSymbols = numberOfSymbols;
+
+		int32 seed = 1;
+		TArray<FColumnsGame> games;
+		games.SetNum(numberOfBoards);
+		for (FColumnsGame& game : games)
+		{
+			game.Reset(settings, seed++);
+		}
+
+		FColumnsRandom random(4);
+		int64 operations = 0;
+		double seconds = 0.0;
+
+		for (auto move = 0; move < COLUMNS_BENCHMARK_WARM_UP_MOVES + rounds; move++)
+		{
+			for (FColumnsGame& game : games)
+			{
+				if (game.IsGameOver()) game.Reset(settings, seed++);
+
+				const int64 allocationsBefore = allocationCounter.GetCount();
+				const double startSeconds = FPlatformTime::Seconds();
+
+				DropInLowestColumn(game, random);
+
+				if (move < COLUMNS_BENCHMARK_WARM_UP_MOVES) continue;
+
+				seconds += FPlatformTime::Seconds() - startSeconds;
+				moveAllocations += allocationCounter.GetCount() - allocationsBefore;
+				operations++;
+			}
+		}
+
+		for (const FColumnsGame& game : games)
+		{
+			checksum += game.GetScore();
+		}
+
+		const double nsPerOp = seconds * 1.0e9 / operations;
+		const double allocationsPerOp = (double)moveAllocations / operations;
+
+		UE_LOG(LogColumns, Display, TEXT("%-22s %-15s %10.1f ns/op %8.2f allocs/op (%lld ops)"),
+			TEXT("Move"), TEXT("games"), nsPerOp, allocationsPerOp, operations);
+
+		csv += FString::Printf(TEXT("%s,%s,%s,%d,%d,%d,%d,%lld,%f,%f\n"), *label, TEXT("Move"), TEXT("games"),
+			numberOfColumns, numberOfRows, numberOfSymbols, games.Num(), operations, nsPerOp, allocationsPerOp);
+	}
+
+	// the greedy policy choosing a placement, as the simulate commandlet plays every move; it values the
+	// placements on a batch of boards with the best batch kernel, or on copies of the game if the board is too big
+	if (filter.IsEmpty() || FString(TEXT("Greedy")).Contains(filter))
+	{
+		FColumnsGameSettings settings;
+		settings.NumberOfColumns = numberOfColumns;
+		settings.NumberOfRows = numberOfRows;
+		settings.NumberOfSymbols = numberOfSymbols;
+
+		int32 seed = 1;
+		TArray<FColumnsGame> games;
+		games.SetNum(numberOfBoards);
+		for (FColumnsGame& game : games)
+		{
+			game.Reset(settings, seed++);
+		}
+
+		FColumnsRandom random(6);
+		int64 operations = 0;
+		int64 allocations = 0;
+		double seconds = 0.0;
+
+		// warm up as the move benchmark does, so the batch and scratch arrays have grown before counting
+		for (auto move = 0; move < COLUMNS_BENCHMARK_WARM_UP_MOVES + rounds; move++)
+		{
+			for (FColumnsGame& game : games)
+			{
+				if (game.IsGameOver()) game.Reset(settings, seed++);
+
+				const int64 allocationsBefore = allocationCounter.GetCount();
+				const double startSeconds = FPlatformTime::Seconds();
+				const FColumnsPlacement placement = FColumnsPolicy::ChoosePlacement(EColumnsPolicy::GREEDY, game, random);
+				const double elapsedSeconds = FPlatformTime::Seconds() - startSeconds;
+				const int64 placementAllocations = allocationCounter.GetCount() - allocationsBefore;
+
+				game.DropPiece(placement.Column, placement.ShuffleDowns);
+
+				if (move < COLUMNS_BENCHMARK_WARM_UP_MOVES) continue;
+
+				seconds += elapsedSeconds;
+				allocations += placementAllocations;
+				operations++;
+			}
+		}
+
+		for (const FColumnsGame& game : games)
+		{
+			checksum += game.GetScore();
+		}
+
+		const double nsPerOp = seconds * 1.0e9 / operations;
+		const double allocationsPerOp = (double)allocations / operations;
+		const FString corpusName = FBoardBatch::Fits(numberOfColumns, numberOfRows, numberOfSymbols) ? FBoardBatchKernel::Best().Name : TEXT("copies");
+
+		UE_LOG(LogColumns, Display, TEXT("%-22s %-15s %10.1f ns/op %8.2f allocs/op (%lld ops)"),
+			TEXT("Greedy"), *corpusName, nsPerOp, allocationsPerOp, operations);
+
+		csv += FString::Printf(TEXT("%s,%s,%s,%d,%d,%d,%d,%lld,%f,%f\n"), *label, TEXT("Greedy"), *corpusName,
+			numberOfColumns, numberOfRows, numberOfSymbols, games.Num(), operations, nsPerOp, allocationsPerOp);
+	}
+
+	// the vectorized environment stepping every game at once, resolving each game's cascade on its own board
+	// and then on board batches; its threads' allocations are counted along with the calling thread's
+	int64 environmentAllocations = 0;
+	for (auto batched = 0; batched < 2; batched++)
+	{
+		if (!filter.IsEmpty() && !FString(TEXT("Environment")).Contains(filter)) break;
+
+		FColumnsEnvironmentSettings settings;
+		settings.Game.NumberOfColumns = numberOfColumns;
+		settings.Game.NumberOfRows = numberOfRows;
+		settings.Game.NumberOfSymbols = numberOfSymbols;
+		settings.NumberOfGames = numberOfBoards;
+		settings.NumberOfThreads = numberOfThreads;
+		settings.bBatchCascades = batched != 0;
+
+		FColumnsEnvironment environment;
+		environment.Init(settings);
+		if (settings.bBatchCascades && !environment.IsBatchingCascades()) break;
+
+		environment.Reset(1);
+
+		for (auto worker = 0; worker < environment.GetNumberOfWorkers(); worker++)
+		{
+			if (!allocationCounter.AddThread(environment.GetWorkerThreadId(worker)))
+			{
+				UE_LOG(LogColumns, Warning, TEXT("Only counting the allocations of %d environment threads."), worker);
+				break;
+			}
+		}
+
+		TArray<int32> actions;
+		actions.SetNumZeroed(environment.GetNumberOfGames());
+
+		FColumnsRandom random(5);
+		int64 operations = 0;
+		int64 allocations = 0;
+		double seconds = 0.0;
+
+		for (auto step = 0; step < COLUMNS_BENCHMARK_WARM_UP_MOVES + rounds; step++)
+		{
+			// a random action the mask allows, or the first one after it that it does
+			for (auto game = 0; game < environment.GetNumberOfGames(); game++)
+			{
+				const uint8* mask = environment.GetActionMasks() + game * environment.GetNumberOfActions();
+				int32 action = random.RandRange(0, environment.GetNumberOfActions() - 1);
+				for (auto tries = 0; tries < environment.GetNumberOfActions() && mask[action] == 0; tries++)
+				{
+					action = (action + 1) % environment.GetNumberOfActions();
+				}
+				actions[game] = action;
+			}
+
+			const int64 allocationsBefore = allocationCounter.GetCount();
+			const double startSeconds = FPlatformTime::Seconds();
+
+			environment.Step(actions.GetData());
+
+			if (step < COLUMNS_BENCHMARK_WARM_UP_MOVES) continue;
+
+			seconds += FPlatformTime::Seconds() - startSeconds;
+			allocations += allocationCounter.GetCount() - allocationsBefore;
+			operations += environment.GetNumberOfGames();
+		}
+		environmentAllocations += allocations;
+
+		for (auto game = 0; game < environment.GetNumberOfGames(); game++)
+		{
+			checksum += environment.GetGame(game).GetScore();
+		}
+
+		const double nsPerOp = seconds * 1.0e9 / operations;
+		const double allocationsPerOp = (double)allocations / operations;
+		const FString corpusName = FString::Printf(TEXT("%s-threads%d"),
+			environment.IsBatchingCascades() ? FBoardBatchKernel::Best().Name : TEXT("board"), numberOfThreads);
+
+		UE_LOG(LogColumns, Display, TEXT("%-22s %-15s %10.1f ns/op %8.2f allocs/op (%lld ops)"),
+			TEXT("Environment"), *corpusName, nsPerOp, allocationsPerOp, operations);
+
+		csv += FString::Printf(TEXT("%s,%s,%s,%d,%d,%d,%d,%lld,%f,%f\n"), *label, TEXT("Environment"), *corpusName,
+			numberOfColumns, numberOfRows, numberOfSymbols, environment.GetNumberOfGames(), operations, nsPerOp, allocationsPerOp);
+	}
+
+	allocationCounter.Unregister();
+
+	// keeps the results of the operations alive, so none of them can be optimized away
+	UE_LOG(LogColumns, Verbose, TEXT("Checksum %lld."), checksum);
+
+	if (!FFileHelper::SaveStringToFile(csv, *outputPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
+	{
+		UE_LOG(LogColumns, Error, TEXT("Failed to write %s."), *outputPath);
+		return 1;
+	}
+
+	UE_LOG(LogColumns, Display, TEXT("Wrote %s."), *outputPath);
+
+	if (bBatchMismatch)
+	{
+		UE_LOG(LogColumns, Error, TEXT("A batch kernel's cascade disagrees with the board's own."));
+		return 1;
+	}
+
+	// a move in steady state, cascade and all, must not touch the heap
+	if (moveAllocations > 0)
+	{
+		UE_LOG(LogColumns, Error, TEXT("Moves made %lld heap allocations after warming up; expected none."), moveAllocations);
+		return 1;
+	}
+
+	if (environmentAllocations > 0)
+	{
+		UE_LOG(LogColumns, Error, TEXT("Environment steps made %lld heap allocations after warming up; expected none."), environmentAllocations);
+		return 1;
+	}
+
+	return 0;
+}
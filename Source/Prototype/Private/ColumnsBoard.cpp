@@ -0,0 +1,567 @@
+// Copyright 2019
+#include "ColumnsBoard.h"
+
+#include "HAL/IConsoleManager.h"
+
+#if !UE_BUILD_SHIPPING
+static TAutoConsoleVariable<int32> CVarVerifyDirtyMatches(
+	TEXT("Columns.VerifyDirtyMatches"),
+	0,
+	TEXT("Cross-check the dirty cell match search against a full board search after every move.\n")
+	TEXT("0: off, 1: on"),
+	ECVF_Cheat);
+#endif
+
+void FColumnsBoard::AddMatchesThrough(int32 row, int32 column, TArray<FRowColumn>& locations) const
+{
+	// check the symbol at the location; if empty, skip
+	const int32 matchSymbol = Get(row, column);
+	if (matchSymbol == 0) return;
+
+	// get horizontal range of matches
+	int32 horizStart = column;
+	while (horizStart > 0 && Get(row, horizStart - 1) == matchSymbol) horizStart--;
+
+	int32 horizEnd = column;
+	while (horizEnd < (NumberOfColumns - 1) && Get(row, horizEnd + 1) == matchSymbol) horizEnd++;
+
+	const int32 horizRangeCount = horizEnd - horizStart + 1;
+
+	// get vertical range of matches
+	int32 vertStart = row;
+	while (vertStart > 0 && Get(vertStart - 1, column) == matchSymbol) vertStart--;
+
+	int32 vertEnd = row;
+	while (vertEnd < (NumberOfRows - 1) && Get(vertEnd + 1, column) == matchSymbol) vertEnd++;
+
+	const int32 vertRangeCount = vertEnd - vertStart + 1;
+
+	// get angled up right matches
+	int32 upRight[2] = { row, column };
+	while (upRight[0] > 0 && upRight[1] < (NumberOfColumns - 1) && Get(upRight[0] - 1, upRight[1] + 1) == matchSymbol)
+	{
+		upRight[0]--;
+		upRight[1]++;
+	}
+
+	int32 downLeft[2] = { row, column };
+	while (downLeft[0] < (NumberOfRows - 1) && downLeft[1] > 0 && Get(downLeft[0] + 1, downLeft[1] - 1) == matchSymbol)
+	{
+		downLeft[0]++;
+		downLeft[1]--;
+	}
+
+	const int32 angledUpCount = upRight[1] - downLeft[1] + 1;
+
+	// get angled down right matches
+	int32 downRight[2] = { row, column };
+	while (downRight[0] < (NumberOfRows - 1) && downRight[1] < (NumberOfColumns - 1)
+		&& Get(downRight[0] + 1, downRight[1] + 1) == matchSymbol)
+	{
+		downRight[0]++;
+		downRight[1]++;
+	}
+
+	int32 upLeft[2] = { row, column };
+	while (upLeft[0] > 0 && upLeft[1] > 0 && Get(upLeft[0] - 1, upLeft[1] - 1) == matchSymbol)
+	{
+		upLeft[0]--;
+		upLeft[1]--;
+	}
+
+	const int32 angledDownCount = downRight[1] - upLeft[1] + 1;
+
+	// if any direction matched 3 or more, proceed to mark for removal
+	if (horizRangeCount > 2 || vertRangeCount > 2 || angledUpCount > 2 || angledDownCount > 2)
+	{
+		// add the locations to remove, starting with center
+		locations.Add(FRowColumn(row, column));
+
+		if (horizRangeCount > 2)
+		{
+			for (auto cspan = horizStart; cspan <= horizEnd; cspan++) {
+				// make sure to skip the center, it was added first
+				if (cspan == column) continue;
+				
+				locations.Add(FRowColumn(row, cspan));
+			}
+		}
+
+		if (vertRangeCount > 2)
+		{
+			for (auto rspan = vertStart; rspan <= vertEnd; rspan++)
+			{
+				if (rspan == row) continue;
+				
+				locations.Add(FRowColumn(rspan, column));
+			}
+		}
+
+		if (angledUpCount > 2)
+		{
+			int32 rspan = downLeft[0];
+			for (auto cspan = downLeft[1]; cspan <= upRight[1]; cspan++)
+			{
+				if (rspan == row && cspan == column) {
+					rspan--;
+					continue;
+				}
+				
+				locations.Add(FRowColumn(rspan, cspan));
+				rspan--;
+			}
+		}
+
+		if (angledDownCount > 2)
+		{
+			int32 rspan = upLeft[0];
+			for (auto cspan = upLeft[1]; cspan <= downRight[1]; cspan++)
+			{
+				if (rspan == row && cspan == column) {
+					rspan++;
+					continue;
+				}
+				
+				locations.Add(FRowColumn(rspan, cspan));
+				rspan++;
+			}
+		}
+	}
+}
+
+void FColumnsBoard::CellChanged(int32 index, int32 oldSymbol, int32 newSymbol)
+{
+	if (bUseBitboard) Bitboard.Set(index / NumberOfColumns, index % NumberOfColumns, oldSymbol, newSymbol);
+	Hash ^= FColumnsZobrist::CellKey(index, oldSymbol) ^ FColumnsZobrist::CellKey(index, newSymbol);
+}
+
+EDirections FColumnsBoard::CheckForAdjacentThree(int32 row, int32 column) const
+{
+	const int32 index = row * NumberOfColumns + column;
+
+	// check that the index to check from exists
+	if (index >= Cells.Num())
+	{
+		return EDirections::INDETERMINATE;
+	}
+
+	// get the symbol to match against
+	const int32 matchSymbol = Cells[index];
+
+	// check left
+	if (column > 1)
+	{
+		if (Get(row, column - 1) == matchSymbol
+			&& Get(row, column - 2) == matchSymbol)
+			return EDirections::LEFT;
+	}
+
+	// check down left
+	if (column > 1 && row < (NumberOfRows - 2))
+	{
+		if (Get(row + 1, column - 1) == matchSymbol
+			&& Get(row + 2, column - 2) == matchSymbol)
+			return EDirections::DOWN_LEFT;
+	}
+
+	// check down
+	if (row < (NumberOfRows - 2))
+	{
+		if (Get(row + 1, column) == matchSymbol
+			&& Get(row + 2, column) == matchSymbol)
+			return EDirections::DOWN;
+	}
+
+	// check down right
+	if (row < (NumberOfRows - 2) && column < (NumberOfColumns - 2))
+	{
+		if (Get(row + 1, column + 1) == matchSymbol
+			&& Get(row + 2, column + 2) == matchSymbol)
+			return EDirections::DOWN_RIGHT;
+	}
+
+	// check right
+	if (column < (NumberOfColumns - 2))
+	{
+		if (Get(row, column + 1) == matchSymbol
+			&& Get(row, column + 2) == matchSymbol)
+			return EDirections::RIGHT;
+	}
+
+	// check up right
+	if (row > 1 && column < (NumberOfColumns - 2))
+	{
+		if (Get(row - 1, column + 1) == matchSymbol
+			&& Get(row - 2, column + 2) == matchSymbol)
+			return EDirections::UP_RIGHT;
+	}
+
+	// check up
+	if (row > 1)
+	{
+		if (Get(row - 1, column) == matchSymbol
+			&& Get(row - 2, column) == matchSymbol)
+			return EDirections::UP;
+	}
+
+	// check up left
+	if (row > 1 && column > 1)
+	{
+		if (Get(row - 1, column - 1) == matchSymbol
+			&& Get(row - 2, column - 2) == matchSymbol)
+			return EDirections::UP_LEFT;
+	}
+
+	return EDirections::INDETERMINATE;
+}
+
+void FColumnsBoard::ClearDirty()
+{
+	for (auto index = 0; index < DirtyCells.Num(); index++)
+	{
+		DirtyFlags[DirtyCells[index].Row * NumberOfColumns + DirtyCells[index].Column] = false;
+	}
+
+	DirtyCells.Reset();
+}
+
+void FColumnsBoard::CollapseEmpty(TArray<FSymbolFall>& outFalls)
+{
+	outFalls.Reset();
+
+	// compact the cells of each column from the bottom up; every symbol lands on the next free row below it
+	if (Kernel != nullptr) Kernel->CollapseEmpty(Cells.GetData(), outFalls);
+	else FBoardKernel::CollapseEmptyRuntime(NumberOfColumns, NumberOfRows, Cells.GetData(), outFalls);
+
+	// the cells have moved; bring the hash, bitboard and dirty cells up to date with them
+	for (auto index = 0; index < outFalls.Num(); index++)
+	{
+		const FSymbolFall& fall = outFalls[index];
+		const int32 toIndex = fall.ToRow * NumberOfColumns + fall.Column;
+		const int32 symbol = Cells[toIndex];
+
+		CellChanged(fall.FromRow * NumberOfColumns + fall.Column, symbol, 0);
+		CellChanged(toIndex, 0, symbol);
+		MarkDirty(fall.ToRow, fall.Column);
+	}
+}
+
+bool FColumnsBoard::CompletesRun(int32 row, int32 column, int32 symbol) const
+{
+	// row and column steps of the four lines through a cell; the run can extend either way along each
+	static const int32 lineSteps[4][2] = { { 0, 1 }, { 1, 0 }, { 1, 1 }, { 1, -1 } };
+
+	for (auto line = 0; line < 4; line++)
+	{
+		const int32 rowStep = lineSteps[line][0];
+		const int32 columnStep = lineSteps[line][1];
+
+		int32 runLength = 1;
+		for (auto step = 1; Get(row + rowStep * step, column + columnStep * step) == symbol; step++) runLength++;
+		for (auto step = 1; Get(row - rowStep * step, column - columnStep * step) == symbol; step++) runLength++;
+
+		if (runLength >= GAME_BOARD_MATCH_LENGTH) return true;
+	}
+
+	return false;
+}
+
+void FColumnsBoard::Construct(int32 rowToStartRandomSymbols, FColumnsRandom& random)
+{
+	// empty out the board
+	Init(NumberOfColumns, NumberOfRows, NumberOfSymbols);
+
+	FillRows(rowToStartRandomSymbols, NumberOfRows - rowToStartRandomSymbols, random);
+}
+
+void FColumnsBoard::FillRows(int32 firstRow, int32 numberOfRows, FColumnsRandom& random)
+{
+	const int32 lastRow = FMath::Min(firstRow + numberOfRows, NumberOfRows);
+
+	// the random symbols shouldn't auto-solve the puzzle, so each cell only draws from the symbols that
+	// don't complete a run with the ones already placed; filling in order means every run is checked
+	// by its last cell to be placed
+	TArray<int32, TInlineAllocator<16>> allowedSymbols;
+
+	// set marks every new symbol dirty for the first match check
+	for (auto row = firstRow; row < lastRow; row++)
+	{
+		for (auto column = 0; column < NumberOfColumns; column++)
+		{
+			allowedSymbols.Reset();
+			for (auto symbol = 1; symbol <= NumberOfSymbols; symbol++)
+			{
+				if (!CompletesRun(row, column, symbol)) allowedSymbols.Add(symbol);
+			}
+
+			// leave a space in the rare cell where every symbol would complete a run
+			Set(row, column, allowedSymbols.Num() > 0 ? allowedSymbols[random.RandRange(0, allowedSymbols.Num() - 1)] : 0);
+		}
+	}
+}
+
+void FColumnsBoard::FindMatches(TArray<FRowColumn>& outLocations) const
+{
+	outLocations.Reset();
+
+	if (bUseBitboard)
+	{
+		// a run only needs checking if one of its cells is dirty
+		FBitboard128 dirtyMask;
+		for (auto index = 0; index < DirtyCells.Num(); index++)
+		{
+			dirtyMask.SetBit(Bitboard.GetBit(DirtyCells[index].Row, DirtyCells[index].Column));
+		}
+
+		// every symbol's runs come back in one mask, so there is nothing to de-duplicate
+		Bitboard.MaskToLocations(Bitboard.FindMatches(dirtyMask), outLocations);
+		return;
+	}
+
+	// otherwise check the runs around each dirty cell; the match flags stop a cell being added twice
+	if (Kernel != nullptr && Kernel->FindMatches != nullptr)
+	{
+		Kernel->FindMatches(Cells.GetData(), DirtyCells.GetData(), DirtyCells.Num(), MatchFlags.GetData(), outLocations);
+	}
+	else
+	{
+		FBoardKernel::FindMatchesRuntime(NumberOfColumns, NumberOfRows, GAME_BOARD_MATCH_LENGTH,
+			Cells.GetData(), DirtyCells.GetData(), DirtyCells.Num(), MatchFlags.GetData(), outLocations);
+	}
+
+	// clear only the flags that were set, and give the locations in row-major order like the bitboard does
+	for (auto index = 0; index < outLocations.Num(); index++)
+	{
+		MatchFlags[outLocations[index].Row * NumberOfColumns + outLocations[index].Column] = false;
+	}
+
+	outLocations.Sort([](const FRowColumn& a, const FRowColumn& b)
+	{
+		return a.Row < b.Row || (a.Row == b.Row && a.Column < b.Column);
+	});
+}
+
+int32 FColumnsBoard::Get(const int32 row, const int32 column) const
+{
+	const int32 index = row * NumberOfColumns + column;
+
+	if (index >= 0 && index < Cells.Num())
+	{
+		return Cells[index];
+	}
+
+	// return no symbol if off the edge of the board
+	return 0;
+}
+
+int32 FColumnsBoard::GetFirstFilledRow() const
+{
+	for (auto index = 0; index < Cells.Num(); index++)
+	{
+		if (Cells[index] != 0) return index / NumberOfColumns;
+	}
+
+	return NumberOfRows;
+}
+
+int32 FColumnsBoard::GetRowToStartRandomSymbols(int32 numberOfRows, int32 filledRows)
+{
+	// keep at least 2 rows of symbols, and at least 4 empty rows for the pawn to enter
+	const int32 maxRowToStartSymbols = numberOfRows - 2;
+	const int32 minRowToStartSymbols = 4;
+
+	return FMath::Clamp(numberOfRows - filledRows, minRowToStartSymbols, maxRowToStartSymbols);
+}
+
+void FColumnsBoard::Init(int32 numberOfColumns, int32 numberOfRows, int32 numberOfSymbols)
+{
+	NumberOfColumns = numberOfColumns;
+	NumberOfRows = numberOfRows;
+	NumberOfSymbols = numberOfSymbols;
+
+	Cells.Init(0, NumberOfColumns * NumberOfRows);
+	FirstRow = 0;
+	Hash = 0;
+
+	// use the bitboard if it fits; set keeps it in sync from here on
+	bUseBitboard = FBoardBitboard::Fits(NumberOfColumns, NumberOfRows, NumberOfSymbols);
+	if (bUseBitboard) Bitboard.Reset(NumberOfColumns, NumberOfRows);
+
+	// the board's own match and collapse loops, if its size has them
+	Kernel = FBoardKernel::Find(NumberOfColumns, NumberOfRows, GAME_BOARD_MATCH_LENGTH);
+
+	// a cell is only ever in the dirty cells once, so they never need more room than this
+	DirtyCells.Reset();
+	DirtyCells.Reserve(Cells.Num());
+	DirtyFlags.Init(false, Cells.Num());
+	MatchFlags.Init(false, Cells.Num());
+}
+
+void FColumnsBoard::MarkDirty(int32 row, int32 column)
+{
+	const int32 index = row * NumberOfColumns + column;
+
+	if (index >= 0 && index < DirtyFlags.Num() && !DirtyFlags[index])
+	{
+		DirtyFlags[index] = true;
+		DirtyCells.Add(FRowColumn(index / NumberOfColumns, index % NumberOfColumns));
+	}
+}
+
+void FColumnsBoard::Pack(uint64* words, int32 bitsPerCell) const
+{
+	const int32 cellsPerWord = 64 / bitsPerCell;
+	const int32 numberOfWords = (Cells.Num() + cellsPerWord - 1) / cellsPerWord;
+
+	for (auto word = 0; word < numberOfWords; word++)
+	{
+		// the last word may be part full
+		const int32 firstIndex = word * cellsPerWord;
+		const int32 lastIndex = FMath::Min(firstIndex + cellsPerWord, Cells.Num());
+
+		uint64 packed = 0;
+		for (auto index = lastIndex - 1; index >= firstIndex; index--)
+		{
+			packed = (packed << bitsPerCell) | (uint64)Cells[index];
+		}
+		words[word] = packed;
+	}
+}
+
+void FColumnsBoard::RemoveMatches(TArray<FRowColumn>& outLocations)
+{
+	// only lines through cells changed since the last check can hold a new match
+	FindMatches(outLocations);
+
+#if !UE_BUILD_SHIPPING
+	if (CVarVerifyDirtyMatches.GetValueOnAnyThread() != 0)
+	{
+		// compare against walking the lines through every cell, as sets of board indicies
+		TArray<FRowColumn> fullMatches;
+		for (auto row = 0; row < NumberOfRows; row++)
+		{
+			for (auto column = 0; column < NumberOfColumns; column++)
+			{
+				AddMatchesThrough(row, column, fullMatches);
+			}
+		}
+
+		TBitArray<> found(false, Cells.Num());
+		for (auto index = 0; index < outLocations.Num(); index++)
+		{
+			found[outLocations[index].Row * NumberOfColumns + outLocations[index].Column] = true;
+		}
+
+		TBitArray<> expected(false, Cells.Num());
+		for (auto index = 0; index < fullMatches.Num(); index++)
+		{
+			expected[fullMatches[index].Row * NumberOfColumns + fullMatches[index].Column] = true;
+		}
+
+		ensureMsgf(found == expected, TEXT("Dirty cell match search disagrees with the full board search (%d dirty cells)."), DirtyCells.Num());
+	}
+#endif
+
+	// everything changed has now been checked
+	ClearDirty();
+
+	// remove symbols
+	for (auto index = 0; index < outLocations.Num(); index++)
+	{
+		Set(outLocations[index].Row, outLocations[index].Column, 0);
+	}
+}
+
+void FColumnsBoard::RetireRows(int32 numberOfRows)
+{
+	numberOfRows = FMath::Clamp(numberOfRows, 0, NumberOfRows);
+	if (numberOfRows == 0) return;
+
+	// move the cells up in place; only cells whose symbol changes touch the hash and bitboard
+	const int32 shift = numberOfRows * NumberOfColumns;
+	for (auto index = 0; index < Cells.Num(); index++)
+	{
+		checkSlow(index >= shift || Cells[index] == 0);
+
+		const int32 symbol = index + shift < Cells.Num() ? Cells[index + shift] : 0;
+		if (symbol == Cells[index]) continue;
+
+		CellChanged(index, Cells[index], symbol);
+		Cells[index] = symbol;
+	}
+
+	// cells waiting for a match check move up with their symbols; compacted in place to keep the allocation
+	int32 keptDirtyCells = 0;
+	for (auto index = 0; index < DirtyCells.Num(); index++)
+	{
+		const FRowColumn& cell = DirtyCells[index];
+		DirtyFlags[cell.Row * NumberOfColumns + cell.Column] = false;
+
+		if (cell.Row >= numberOfRows) DirtyCells[keptDirtyCells++] = FRowColumn(cell.Row - numberOfRows, cell.Column);
+	}
+
+	DirtyCells.RemoveAt(keptDirtyCells, DirtyCells.Num() - keptDirtyCells, false);
+	for (auto index = 0; index < DirtyCells.Num(); index++)
+	{
+		DirtyFlags[DirtyCells[index].Row * NumberOfColumns + DirtyCells[index].Column] = true;
+	}
+
+	FirstRow += numberOfRows;
+}
+
+int32 FColumnsBoard::ScrollEndless(int32 emptyRows, int32 chunkRows, int32 totalRows, FColumnsRandom& random)
+{
+	int32 retiredRows = 0;
+
+	while (true)
+	{
+		// wait for a whole chunk to clear past the rows kept empty for the trinity to enter
+		const int32 rows = FMath::Min(FMath::Max(1, chunkRows), totalRows - (FirstRow + NumberOfRows));
+		if (rows <= 0 || GetFirstFilledRow() - emptyRows < rows) break;
+
+		RetireRows(rows);
+		FillRows(NumberOfRows - rows, rows, random);
+		retiredRows += rows;
+	}
+
+	return retiredRows;
+}
+
+void FColumnsBoard::Set(int32 row, int32 column, int32 symbol)
+{
+	const int32 index = row * NumberOfColumns + column;
+
+	if (index >= 0 && index < Cells.Num() && symbol <= NumberOfSymbols)
+	{
+		CellChanged(index, Cells[index], symbol);
+		Cells[index] = symbol;
+
+		// a placed symbol can start a new match; an emptied cell cannot
+		if (symbol > 0) MarkDirty(row, column);
+	}
+}
+
+void FColumnsBoard::SetTrinity(const TArray<int32>& symbolsArray, int32 rowStart, int32 column)
+{
+	// symbols to add are indexed 0 to number of unique symbols - 1; need to add one
+	for (auto index = 0; index < symbolsArray.Num(); index++)
+	{
+		Set(index + rowStart, column, symbolsArray[index] + 1);
+	}
+}
+
+void FColumnsBoard::Unpack(const uint64* words, int32 bitsPerCell, int32 firstRow)
+{
+	Init(NumberOfColumns, NumberOfRows, NumberOfSymbols);
+	FirstRow = firstRow;
+
+	const int32 cellsPerWord = 64 / bitsPerCell;
+	const uint64 cellMask = (1ull << bitsPerCell) - 1;
+
+	// set keeps the hash and bitboard in step with the cells
+	for (auto index = 0; index < Cells.Num(); index++)
+	{
+		const int32 symbol = (int32)((words[index / cellsPerWord] >> ((index % cellsPerWord) * bitsPerCell)) & cellMask);
+		if (symbol != 0) Set(index / NumberOfColumns, index % NumberOfColumns, symbol);
+	}
+}
@@ -0,0 +1,55 @@
+// Copyright 2019
+#include "ColumnsCascade.h"
+
+#include "ColumnsBoard.h"
+
+// Steps of falls to make room for up front; a longer cascade grows the array once and keeps it.
+constexpr int32 CASCADE_RESERVED_FALL_STEPS = 4;
+
+// Steps to make room for up front.
+constexpr int32 CASCADE_RESERVED_STEPS = 16;
+
+int32 FColumnsCascade::Resolve(FColumnsBoard& board)
+{
+	Reset();
+
+	// the board's own remove and collapse, until a step neither removes nor drops anything
+	while (true)
+	{
+		board.RemoveMatches(StepRemoved);
+		board.CollapseEmpty(StepFalls);
+
+		if (StepRemoved.Num() == 0 && StepFalls.Num() == 0) break;
+
+		FColumnsCascadeStep& step = Steps.AddDefaulted_GetRef();
+		step.FirstRemoved = Removed.Num();
+		step.NumberOfRemoved = StepRemoved.Num();
+		step.FirstFall = Falls.Num();
+		step.NumberOfFalls = StepFalls.Num();
+
+		Removed.Append(StepRemoved);
+		Falls.Append(StepFalls);
+
+		if (StepRemoved.Num() > 0) Depth++;
+	}
+
+	return Depth;
+}
+
+void FColumnsCascade::Reserve(int32 numberOfCells)
+{
+	// a symbol is only removed once a cascade, but can fall in every step
+	Removed.Reserve(numberOfCells);
+	Falls.Reserve(numberOfCells * CASCADE_RESERVED_FALL_STEPS);
+	Steps.Reserve(CASCADE_RESERVED_STEPS);
+	StepRemoved.Reserve(numberOfCells);
+	StepFalls.Reserve(numberOfCells);
+}
+
+void FColumnsCascade::Reset()
+{
+	Depth = 0;
+	Falls.Reset();
+	Removed.Reset();
+	Steps.Reset();
+}
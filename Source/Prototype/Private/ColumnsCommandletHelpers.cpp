@@ -0,0 +1,47 @@
+// Copyright 2019
+#include "ColumnsCommandletHelpers.h"
+
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Prototype.h"
+
+bool FColumnsCommandletHelpers::AppendCsv(const FString& path, const FString& header, const FString& rows)
+{
+	const FString csv = FPaths::FileExists(path) ? rows : header + TEXT("\n") + rows;
+
+	if (!FFileHelper::SaveStringToFile(csv, *path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
+	{
+		UE_LOG(LogColumns, Error, TEXT("Failed to write %s."), *path);
+		return false;
+	}
+
+	UE_LOG(LogColumns, Display, TEXT("Wrote %s."), *path);
+	return true;
+}
+
+FString FColumnsCommandletHelpers::GetSettingsCsvHeader()
+{
+	return TEXT("Columns,Rows,Symbols,StartLevel,JewelsRequired,FilledRowsBase,FilledRowsPerLevel,Gravity,GravityScale,Endless");
+}
+
+FString FColumnsCommandletHelpers::GetSettingsCsvValues(const FColumnsGameSettings& settings)
+{
+	return FString::Printf(TEXT("%d,%d,%d,%d,%d,%d,%d,%f,%f,%d"),
+		settings.NumberOfColumns, settings.NumberOfRows, settings.NumberOfSymbols, settings.StartLevel, settings.JewelsRequired,
+		settings.FilledRowsBase, settings.FilledRowsPerLevel, settings.GravityPixelsPerSecond, settings.GravityLevelScale,
+		settings.EndlessRows);
+}
+
+void FColumnsCommandletHelpers::ParseSettings(const FString& params, FColumnsGameSettings& outSettings)
+{
+	FParse::Value(*params, TEXT("columns="), outSettings.NumberOfColumns);
+	FParse::Value(*params, TEXT("rows="), outSettings.NumberOfRows);
+	FParse::Value(*params, TEXT("symbols="), outSettings.NumberOfSymbols);
+	FParse::Value(*params, TEXT("startlevel="), outSettings.StartLevel);
+	FParse::Value(*params, TEXT("jewelsrequired="), outSettings.JewelsRequired);
+	FParse::Value(*params, TEXT("filledbase="), outSettings.FilledRowsBase);
+	FParse::Value(*params, TEXT("filledperlevel="), outSettings.FilledRowsPerLevel);
+	FParse::Value(*params, TEXT("gravity="), outSettings.GravityPixelsPerSecond);
+	FParse::Value(*params, TEXT("gravityscale="), outSettings.GravityLevelScale);
+	FParse::Value(*params, TEXT("endless="), outSettings.EndlessRows);
+}
@@ -0,0 +1,213 @@
+// Copyright 2019
+#include "ColumnsDifficultyCommandlet.h"
+
+#include "Async/ParallelFor.h"
+#include "ColumnsCommandletHelpers.h"
+#include "ColumnsGame.h"
+#include "ColumnsPolicy.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+#include "Prototype.h"
+
+// The cascade depths counted apart; the last counts every cascade at least that deep.
+constexpr int32 DIFFICULTY_CASCADE_DEPTHS = 8;
+
+// How a game of one level ended.
+enum class EColumnsLevelOutcome : uint8
+{
+	// The stack reached the top before the level was cleared.
+	LOST,
+
+	// Enough jewels were collected to move on to the next level.
+	CLEARED,
+
+	// Still playing when the pieces ran out.
+	TIMED_OUT,
+};
+
+// The outcome of one game of one level.
+struct FColumnsLevelResult
+{
+	EColumnsLevelOutcome Outcome = EColumnsLevelOutcome::TIMED_OUT;
+	int32 Pieces = 0;
+	int32 Score = 0;
+
+	// Landings by the depth of their cascade.
+	int32 CascadeDepths[DIFFICULTY_CASCADE_DEPTHS] = {};
+};
+
+UColumnsDifficultyCommandlet::UColumnsDifficultyCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UColumnsDifficultyCommandlet::Main(const FString& Params)
+{
+	int32 games = 2000;
+	int32 seed = 1;
+	int32 maxPieces = 1000;
+	int32 firstLevel = 1;
+	int32 lastLevel = 10;
+	float inputIntervalSeconds = GAME_BOARD_SPACING / PAWN_SPEED_PIXELS_PER_SECOND;
+	FString policyName = TEXT("greedy");
+	FString outputPath = FPaths::ProjectSavedDir() / TEXT("ColumnsDifficulty.csv");
+
+	FParse::Value(*Params, TEXT("games="), games);
+	FParse::Value(*Params, TEXT("seed="), seed);
+	FParse::Value(*Params, TEXT("maxpieces="), maxPieces);
+	FParse::Value(*Params, TEXT("firstlevel="), firstLevel);
+	FParse::Value(*Params, TEXT("lastlevel="), lastLevel);
+	FParse::Value(*Params, TEXT("inputinterval="), inputIntervalSeconds);
+	FParse::Value(*Params, TEXT("policy="), policyName);
+	FParse::Value(*Params, TEXT("output="), outputPath);
+	if (FParse::Param(*Params, TEXT("instant"))) inputIntervalSeconds = 0.0f;
+
+	// each game starts at its own level, so -startlevel= is overridden
+	FColumnsGameSettings settings;
+	FColumnsCommandletHelpers::ParseSettings(Params, settings);
+
+	EColumnsPolicy policy;
+	if (!FColumnsPolicy::Parse(policyName, policy))
+	{
+		UE_LOG(LogColumns, Error, TEXT("Unknown policy '%s'; use random, greedy or search."), *policyName);
+		return 1;
+	}
+
+	if (games <= 0 || maxPieces <= 0 || firstLevel < 1 || lastLevel < firstLevel
+		|| settings.NumberOfColumns <= 0 || settings.NumberOfRows <= PAWN_SIZE || settings.NumberOfSymbols <= 0)
+	{
+		UE_LOG(LogColumns, Error, TEXT("Nothing to simulate; check -games, -maxpieces, -firstlevel, -lastlevel, -columns, -rows and -symbols."));
+		return 1;
+	}
+
+	const int32 numberOfLevels = lastLevel - firstLevel + 1;
+
+	// every level and game is independent and seeded from the game's index, so results don't depend on the
+	// thread count, and each level is played on the same boards and trinities as the others
+	TArray<FColumnsLevelResult> results;
+	results.SetNum(numberOfLevels * games);
+
+	const double startSeconds = FPlatformTime::Seconds();
+
+	ParallelFor(results.Num(), [&](int32 index)
+	{
+		const int32 gameIndex = index % games;
+
+		FColumnsGameSettings levelSettings = settings;
+		levelSettings.StartLevel = firstLevel + index / games;
+
+		FColumnsGame game;
+		game.Reset(levelSettings, seed + gameIndex);
+
+		FColumnsRandom policyRandom(seed + gameIndex);
+		FColumnsLevelResult& result = results[index];
+
+		// a piece at a time, to see the cascade of each landing and stop once the level is cleared
+		while (!game.IsGameOver() && game.GetPiecesPlaced() < maxPieces)
+		{
+			const int32 piecesPlaced = game.GetPiecesPlaced();
+			FColumnsPolicy::PlayGame(game, policy, policyRandom, inputIntervalSeconds, piecesPlaced + 1);
+
+			// count the landing even if it ends the game; a trinity that can't fit on the board isn't placed
+			if (game.GetPiecesPlaced() != piecesPlaced)
+			{
+				result.CascadeDepths[FMath::Min(game.GetLastCascadeDepth(), DIFFICULTY_CASCADE_DEPTHS - 1)]++;
+			}
+
+			if (game.GetLevel() != levelSettings.StartLevel)
+			{
+				result.Outcome = EColumnsLevelOutcome::CLEARED;
+				break;
+			}
+
+			if (game.IsGameOver()) result.Outcome = EColumnsLevelOutcome::LOST;
+		}
+
+		result.Pieces = game.GetPiecesPlaced();
+		result.Score = game.GetScore();
+	});
+
+	const double elapsedSeconds = FPlatformTime::Seconds() - startSeconds;
+
+	UE_LOG(LogColumns, Display, TEXT("Simulated %d games of each of levels %d to %d in %.3f s (%.0f games/s)."),
+		games, firstLevel, lastLevel, elapsedSeconds, elapsedSeconds > 0.0 ? results.Num() / elapsedSeconds : 0.0);
+
+	// append a row per level so runs with different rules end up in one file
+	FString header = TEXT("Games,Policy,Seed,MaxPieces,InputInterval,") + FColumnsCommandletHelpers::GetSettingsCsvHeader()
+		+ TEXT(",SurvivalRate,ClearRate,LossRate,TimeoutRate,MeanPiecesToClear,MeanPieces,MeanScore");
+	for (auto depth = 0; depth < DIFFICULTY_CASCADE_DEPTHS; depth++)
+	{
+		header += FString::Printf(depth < DIFFICULTY_CASCADE_DEPTHS - 1 ? TEXT(",CascadeDepth%d") : TEXT(",CascadeDepth%dOrMore"), depth);
+	}
+
+	FString rows;
+	for (auto levelIndex = 0; levelIndex < numberOfLevels; levelIndex++)
+	{
+		FColumnsGameSettings levelSettings = settings;
+		levelSettings.StartLevel = firstLevel + levelIndex;
+
+		// aggregate
+		int32 cleared = 0, lost = 0, timedOut = 0;
+		double totalPieces = 0.0, totalPiecesToClear = 0.0, totalScore = 0.0, totalLandings = 0.0;
+		double cascadeDepths[DIFFICULTY_CASCADE_DEPTHS] = {};
+		for (auto gameIndex = 0; gameIndex < games; gameIndex++)
+		{
+			const FColumnsLevelResult& result = results[levelIndex * games + gameIndex];
+			switch (result.Outcome)
+			{
+			case EColumnsLevelOutcome::LOST:
+				lost++;
+				break;
+			case EColumnsLevelOutcome::CLEARED:
+				cleared++;
+				totalPiecesToClear += result.Pieces;
+				break;
+			case EColumnsLevelOutcome::TIMED_OUT:
+				timedOut++;
+				break;
+			}
+			totalPieces += result.Pieces;
+			totalScore += result.Score;
+
+			for (auto depth = 0; depth < DIFFICULTY_CASCADE_DEPTHS; depth++)
+			{
+				cascadeDepths[depth] += result.CascadeDepths[depth];
+				totalLandings += result.CascadeDepths[depth];
+			}
+		}
+
+		// a game that's still going when the pieces run out survived the level without clearing it
+		const double clearRate = (double)cleared / games;
+		const double lossRate = (double)lost / games;
+		const double timeoutRate = (double)timedOut / games;
+		const double survivalRate = (double)(cleared + timedOut) / games;
+		const double meanPiecesToClear = cleared > 0 ? totalPiecesToClear / cleared : 0.0;
+
+		// the share of landings that set off each depth of cascade
+		FString distribution;
+		for (auto depth = 0; depth < DIFFICULTY_CASCADE_DEPTHS; depth++)
+		{
+			cascadeDepths[depth] = totalLandings > 0.0 ? cascadeDepths[depth] / totalLandings : 0.0;
+			distribution += FString::Printf(TEXT(" %d%s:%.1f%%"), depth, depth < DIFFICULTY_CASCADE_DEPTHS - 1 ? TEXT("") : TEXT("+"), 100.0 * cascadeDepths[depth]);
+		}
+
+		UE_LOG(LogColumns, Display, TEXT("Level %d: %.1f%% survived (%.1f%% cleared, %.1f%% lost, %.1f%% timed out), %.1f pieces to clear, %.1f mean pieces, %.1f mean score; cascade depths%s."),
+			levelSettings.StartLevel, 100.0 * survivalRate, 100.0 * clearRate, 100.0 * lossRate, 100.0 * timeoutRate,
+			meanPiecesToClear, totalPieces / games, totalScore / games, *distribution);
+
+		rows += FString::Printf(TEXT("%d,%s,%d,%d,%f,"), games, *policyName.ToLower(), seed, maxPieces, inputIntervalSeconds)
+			+ FColumnsCommandletHelpers::GetSettingsCsvValues(levelSettings)
+			+ FString::Printf(TEXT(",%f,%f,%f,%f,%f,%f,%f"), survivalRate, clearRate, lossRate, timeoutRate,
+				meanPiecesToClear, totalPieces / games, totalScore / games);
+		for (auto depth = 0; depth < DIFFICULTY_CASCADE_DEPTHS; depth++)
+		{
+			rows += FString::Printf(TEXT(",%f"), cascadeDepths[depth]);
+		}
+		rows += TEXT("\n");
+	}
+
+	return FColumnsCommandletHelpers::AppendCsv(outputPath, header, rows) ? 0 : 1;
+}
@@ -0,0 +1,310 @@
+// Copyright 2019
+#include "ColumnsEnvironment.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeBool.h"
+
+// A thread that steps one slice of the games each time it's started, and waits in between. The task graph
+// would allocate its tasks every step, so the environment keeps threads of its own.
+class FColumnsEnvironmentWorker : public FRunnable
+{
+
+public:
+
+	FColumnsEnvironmentWorker(FColumnsEnvironment& inEnvironment, int32 inSlice)
+		: Environment(inEnvironment), Slice(inSlice)
+	{
+		StartEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		DoneEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("ColumnsEnvironment%d"), inSlice));
+	}
+
+	virtual ~FColumnsEnvironmentWorker()
+	{
+		if (Thread != nullptr)
+		{
+			Thread->Kill(true);
+			delete Thread;
+		}
+
+		FPlatformProcess::ReturnSynchEventToPool(StartEvent);
+		FPlatformProcess::ReturnSynchEventToPool(DoneEvent);
+	}
+
+	virtual uint32 Run() override
+	{
+		while (true)
+		{
+			StartEvent->Wait();
+			if (bStopping) return 0;
+
+			Environment.StepSlice(Slice);
+			DoneEvent->Trigger();
+		}
+	}
+
+	virtual void Stop() override
+	{
+		bStopping = true;
+		StartEvent->Trigger();
+	}
+
+	// Returns the id of the thread.
+	FORCEINLINE uint32 GetThreadId() const { return Thread != nullptr ? Thread->GetThreadID() : 0; }
+
+	// Step the slice on the thread.
+	FORCEINLINE void Start() { StartEvent->Trigger(); }
+
+	// Wait for the slice to be stepped.
+	FORCEINLINE void Wait() { DoneEvent->Wait(); }
+
+protected:
+
+	// Whether the thread has been asked to finish.
+	FThreadSafeBool bStopping;
+
+	// Triggered by the thread once its slice is stepped.
+	FEvent* DoneEvent = nullptr;
+
+	// The environment whose games are stepped.
+	FColumnsEnvironment& Environment;
+
+	// The slice of the games the thread steps.
+	int32 Slice = 0;
+
+	// Triggered to step the slice.
+	FEvent* StartEvent = nullptr;
+
+	// The thread running the worker.
+	FRunnableThread* Thread = nullptr;
+};
+
+FColumnsPlacement FColumnsEnvironment::ActionToPlacement(int32 action)
+{
+	FColumnsPlacement placement;
+	placement.Column = action / PAWN_SIZE;
+	placement.ShuffleDowns = action % PAWN_SIZE;
+	return placement;
+}
+
+int32 FColumnsEnvironment::PlacementToAction(const FColumnsPlacement& placement)
+{
+	return placement.Column * PAWN_SIZE + placement.ShuffleDowns;
+}
+
+FColumnsEnvironment::~FColumnsEnvironment()
+{
+	// each worker stops and joins its thread as it's destroyed
+	for (FColumnsEnvironmentWorker* worker : Workers)
+	{
+		delete worker;
+	}
+}
+
+void FColumnsEnvironment::FinishStep(int32 index, int32 scoreBefore)
+{
+	FColumnsGame& game = Games[index];
+
+	Rewards[index] = (float)(game.GetScore() - scoreBefore);
+	Dones[index] = game.IsGameOver() || (Settings.MaxPieces > 0 && game.GetPiecesPlaced() >= Settings.MaxPieces);
+
+	if (Dones[index])
+	{
+		EpisodeScores[index] = game.GetScore();
+		game.Reset(Settings.Game, NextSeeds[index]);
+		NextSeeds[index] += Games.Num();
+	}
+
+	WriteObservation(index);
+}
+
+uint32 FColumnsEnvironment::GetWorkerThreadId(int32 index) const
+{
+	return Workers[index]->GetThreadId();
+}
+
+void FColumnsEnvironment::Init(const FColumnsEnvironmentSettings& inSettings)
+{
+	check(Workers.Num() == 0);
+
+	Settings = inSettings;
+	Settings.NumberOfGames = FMath::Max(1, Settings.NumberOfGames);
+	Settings.NumberOfThreads = FMath::Clamp(Settings.NumberOfThreads, 0, Settings.NumberOfGames - 1);
+
+	const FColumnsGameSettings& game = Settings.Game;
+	NumberOfActions = game.NumberOfColumns * PAWN_SIZE;
+	ObservationSize = game.NumberOfColumns * game.NumberOfRows + 2 * PAWN_SIZE;
+
+	Games.SetNum(Settings.NumberOfGames);
+	NextSeeds.SetNumZeroed(Settings.NumberOfGames);
+	Observations.SetNumZeroed(Settings.NumberOfGames * ObservationSize);
+	ActionMasks.SetNumZeroed(Settings.NumberOfGames * NumberOfActions);
+	Rewards.SetNumZeroed(Settings.NumberOfGames);
+	Dones.SetNumZeroed(Settings.NumberOfGames);
+	EpisodeScores.SetNumZeroed(Settings.NumberOfGames);
+
+	GamesPerSlice = FMath::DivideAndRoundUp(Settings.NumberOfGames, Settings.NumberOfThreads + 1);
+
+	if (Settings.bBatchCascades && FBoardBatch::Fits(game.NumberOfColumns, game.NumberOfRows, game.NumberOfSymbols))
+	{
+		Batches.SetNum(Settings.NumberOfThreads + 1);
+		for (FBoardBatch& batch : Batches)
+		{
+			batch.Init(game.NumberOfColumns, game.NumberOfRows);
+		}
+	}
+
+	for (auto index = 0; index < Settings.NumberOfThreads; index++)
+	{
+		Workers.Add(new FColumnsEnvironmentWorker(*this, index + 1));
+	}
+}
+
+void FColumnsEnvironment::Reset(int32 seed)
+{
+	for (auto index = 0; index < Games.Num(); index++)
+	{
+		Games[index].Reset(Settings.Game, seed + index);
+		NextSeeds[index] = seed + index + Games.Num();
+		Rewards[index] = 0.0f;
+		Dones[index] = 0;
+		EpisodeScores[index] = 0;
+		WriteObservation(index);
+	}
+}
+
+void FColumnsEnvironment::ResolveBatch(int32 slice, const int32* laneGames, const int32* laneScoresBefore, int32 numberOfLanes)
+{
+	FBoardBatch& batch = Batches[slice];
+
+	// the cascade of every lane a step at a time, scoring each step's jewels as the game would; the lanes past
+	// the games placed hold boards that have settled, so they're left as they are
+	int32 jewels[BOARD_BATCH_LANES] = {};
+	int32 scores[BOARD_BATCH_LANES] = {};
+	int32 depths[BOARD_BATCH_LANES] = {};
+	uint8 removed[BOARD_BATCH_LANES];
+	while (true)
+	{
+		const bool bRemoved = batch.RemoveMatches(removed);
+		const bool bFell = batch.CollapseEmpty();
+		if (!bRemoved && !bFell) break;
+
+		for (auto lane = 0; lane < numberOfLanes; lane++)
+		{
+			if (removed[lane] == 0) continue;
+
+			jewels[lane] += removed[lane];
+			scores[lane] += FColumnsGame::ScoreForJewels(removed[lane]);
+			depths[lane]++;
+		}
+	}
+
+	for (auto lane = 0; lane < numberOfLanes; lane++)
+	{
+		const int32 index = laneGames[lane];
+		Games[index].FinishPlacedPiece(batch, lane, jewels[lane], scores[lane], depths[lane]);
+		FinishStep(index, laneScoresBefore[lane]);
+	}
+}
+
+void FColumnsEnvironment::Step(const int32* actions)
+{
+	PendingActions = actions;
+
+	// the events order the pending actions before the threads read them, and the games after
+	for (auto index = 0; index < Workers.Num(); index++)
+	{
+		Workers[index]->Start();
+	}
+
+	StepSlice(0);
+
+	for (auto index = 0; index < Workers.Num(); index++)
+	{
+		Workers[index]->Wait();
+	}
+
+	PendingActions = nullptr;
+}
+
+void FColumnsEnvironment::StepSlice(int32 slice)
+{
+	const int32 firstGame = slice * GamesPerSlice;
+	const int32 lastGame = FMath::Min(firstGame + GamesPerSlice, Games.Num());
+
+	// the games placed in the slice's batch, waiting for their cascades
+	int32 laneGames[BOARD_BATCH_LANES];
+	int32 laneScoresBefore[BOARD_BATCH_LANES];
+	int32 numberOfLanes = 0;
+
+	for (auto index = firstGame; index < lastGame; index++)
+	{
+		FColumnsGame& game = Games[index];
+		const int32 scoreBefore = game.GetScore();
+
+		// drop piece checks the column before it shuffles, so a refused placement leaves the trinity as it was
+		const FColumnsPlacement placement = ActionToPlacement(PendingActions[index]);
+		if (!IsBatchingCascades())
+		{
+			if (!game.DropPiece(placement.Column, placement.ShuffleDowns)) game.DropPiece(game.GetLocationX(), placement.ShuffleDowns);
+
+			FinishStep(index, scoreBefore);
+			continue;
+		}
+
+		if (!game.PlacePiece(placement.Column, placement.ShuffleDowns)) game.PlacePiece(game.GetLocationX(), placement.ShuffleDowns);
+
+		// a trinity that ended the game has no cascade
+		if (game.IsGameOver())
+		{
+			FinishStep(index, scoreBefore);
+			continue;
+		}
+
+		Batches[slice].LoadBoard(numberOfLanes, game.GetBoard());
+		laneGames[numberOfLanes] = index;
+		laneScoresBefore[numberOfLanes] = scoreBefore;
+		numberOfLanes++;
+
+		if (numberOfLanes == BOARD_BATCH_LANES)
+		{
+			ResolveBatch(slice, laneGames, laneScoresBefore, numberOfLanes);
+			numberOfLanes = 0;
+		}
+	}
+
+	if (numberOfLanes > 0) ResolveBatch(slice, laneGames, laneScoresBefore, numberOfLanes);
+}
+
+void FColumnsEnvironment::WriteObservation(int32 index)
+{
+	const FColumnsGame& game = Games[index];
+	const TArray<int32>& cells = game.GetBoard().GetCells();
+	uint8* observation = Observations.GetData() + index * ObservationSize;
+
+	for (auto cell = 0; cell < cells.Num(); cell++)
+	{
+		observation[cell] = (uint8)cells[cell];
+	}
+
+	uint8* trinities = observation + cells.Num();
+	for (auto symbol = 0; symbol < PAWN_SIZE; symbol++)
+	{
+		trinities[symbol] = (uint8)(game.GetCurrentSymbolIndicies()[symbol] + 1);
+		trinities[PAWN_SIZE + symbol] = (uint8)(game.GetNextSymbolIndicies()[symbol] + 1);
+	}
+
+	// every shuffle of a column is as reachable as the column
+	uint8* mask = ActionMasks.GetData() + index * NumberOfActions;
+	for (auto column = 0; column < game.GetBoard().GetNumberOfColumns(); column++)
+	{
+		const uint8 reachable = game.CanReachColumn(column) ? 1 : 0;
+		for (auto shuffleDowns = 0; shuffleDowns < PAWN_SIZE; shuffleDowns++)
+		{
+			mask[column * PAWN_SIZE + shuffleDowns] = reachable;
+		}
+	}
+}
@@ -0,0 +1,425 @@
+// Copyright 2019
+#include "ColumnsGame.h"
+
+#include "BoardBatchKernel.h"
+
+int32 FColumnsGame::ScoreForJewels(int32 jewels)
+{
+	// Score takes into account the number of jewels collected in one go
+	return jewels * (jewels - 2);
+}
+
+void FColumnsGame::Advance(float deltaSeconds)
+{
+	if (bGameOver) return;
+
+	// keep the fraction of a millisecond for the next advance
+	PendingSeconds += deltaSeconds;
+	const int32 deltaMs = FMath::FloorToInt(PendingSeconds * 1000.0f);
+	if (deltaMs <= 0) return;
+
+	PendingSeconds -= deltaMs / 1000.0f;
+	AdvanceMs(deltaMs);
+}
+
+void FColumnsGame::AdvanceMs(int32 deltaMs)
+{
+	const int64 rowProgress = (int64)GAME_BOARD_SPACING * 1000;
+
+	// step one row at a time so that a long advance can't fall past a landing
+	while (!bGameOver)
+	{
+		if (IsTrinityBlocked())
+		{
+			LandTrinity();
+			return;
+		}
+
+		if (deltaMs <= 0) return;
+
+		// pixels per second is progress per millisecond
+		const int32 speed = FMath::Max(1, MoveDownHeld ? PAWN_SPEED_PIXELS_PER_SECOND : GravityPixelsPerSecond);
+		const int32 msToNextRow = (int32)((rowProgress - FallProgress + speed - 1) / speed);
+
+		if (msToNextRow > deltaMs)
+		{
+			FallProgress += (int64)deltaMs * speed;
+			PieceMs += deltaMs;
+			return;
+		}
+
+		FallProgress += (int64)msToNextRow * speed - rowProgress;
+		PieceMs += msToNextRow;
+		deltaMs -= msToNextRow;
+		LocationY++;
+	}
+}
+
+bool FColumnsGame::ApplyInput(EColumnsInput input)
+{
+	if (bGameOver) return false;
+
+	switch (input)
+	{
+	case EColumnsInput::MOVE_LEFT:
+		if (LocationX <= 0 || !IsColumnFree(LocationX - 1)) return false;
+		LocationX--;
+		return true;
+	case EColumnsInput::MOVE_RIGHT:
+		if (LocationX >= (Board.GetNumberOfColumns() - 1) || !IsColumnFree(LocationX + 1)) return false;
+		LocationX++;
+		return true;
+	case EColumnsInput::SHUFFLE_UP:
+	{
+		// top symbol goes to the bottom, rotated in place
+		for (auto index = 0; index < CurrentSymbolIndicies.Num() - 1; index++)
+		{
+			CurrentSymbolIndicies.Swap(index, index + 1);
+		}
+		return true;
+	}
+	case EColumnsInput::SHUFFLE_DOWN:
+	{
+		// bottom symbol goes to the top, rotated in place
+		for (auto index = CurrentSymbolIndicies.Num() - 1; index > 0; index--)
+		{
+			CurrentSymbolIndicies.Swap(index, index - 1);
+		}
+		return true;
+	}
+	case EColumnsInput::MOVE_DOWN_PRESSED:
+		// check if above the bottom row and there's room to move down
+		if (MoveDownHeld || IsTrinityBlocked()) return false;
+		MoveDownHeld = true;
+		return true;
+	case EColumnsInput::MOVE_DOWN_RELEASED:
+		if (!MoveDownHeld) return false;
+		MoveDownHeld = false;
+		return true;
+	}
+
+	return false;
+}
+
+bool FColumnsGame::CanReachColumn(int32 column) const
+{
+	if (column < 0 || column >= Board.GetNumberOfColumns()) return false;
+
+	// the trinity has to be able to slide across to the column at its current rows
+	const int32 step = column > LocationX ? 1 : -1;
+	for (auto x = LocationX; x != column; x += step)
+	{
+		if (!IsColumnFree(x + step)) return false;
+	}
+
+	return true;
+}
+
+bool FColumnsGame::CaptureSnapshot(FColumnsSnapshot& outSnapshot) const
+{
+	if (!outSnapshot.PackBoard(Board)) return false;
+
+	outSnapshot.SetTrinities(CurrentSymbolIndicies, NextSymbolIndicies);
+	outSnapshot.BoardRandom = BoardRandom;
+	outSnapshot.PieceRandom = PieceRandom;
+	outSnapshot.FallProgress = FallProgress;
+	outSnapshot.PendingSeconds = PendingSeconds;
+	outSnapshot.PieceMs = PieceMs;
+	outSnapshot.PiecesPlaced = PiecesPlaced;
+	outSnapshot.Score = Score;
+	outSnapshot.TotalJewels = TotalJewels;
+	outSnapshot.Level = (int16)Level;
+	outSnapshot.Jewels = (int16)Jewels;
+	outSnapshot.LastCascadeDepth = (int16)LastCascadeDepth;
+	outSnapshot.MaxCascadeDepth = (int16)MaxCascadeDepth;
+	outSnapshot.LocationX = (int8)LocationX;
+	outSnapshot.LocationY = (int8)LocationY;
+	outSnapshot.bGameOver = bGameOver;
+	outSnapshot.bMoveDownHeld = MoveDownHeld;
+
+	return true;
+}
+
+bool FColumnsGame::DropPiece(int32 column, int32 shuffleDowns)
+{
+	if (!PlacePiece(column, shuffleDowns)) return false;
+
+	if (!bGameOver) FinishLanding(ResolveCascade());
+	return true;
+}
+
+void FColumnsGame::FinishLanding(int32 cascadeDepth)
+{
+	LastCascadeDepth = cascadeDepth;
+	MaxCascadeDepth = FMath::Max(MaxCascadeDepth, LastCascadeDepth);
+
+	// an endless board moves on to the rows below once enough are cleared
+	if (Settings.ScrollEndless(Board, BoardRandom) > 0) bBoardMovedOn = true;
+
+	// check for completion of the level
+	if (Jewels >= Settings.JewelsRequired)
+	{
+		Level++;
+		StartLevel();
+	}
+
+	SpawnTrinity();
+}
+
+void FColumnsGame::FinishPlacedPiece(const FBoardBatch& batch, int32 lane, int32 jewels, int32 score, int32 depth)
+{
+	batch.StoreBoard(lane, Board);
+	Cascade.Reset();
+
+	Jewels += jewels;
+	TotalJewels += jewels;
+	Score += score;
+
+	FinishLanding(depth);
+}
+
+uint64 FColumnsGame::GetHash(bool bWithTrinities) const
+{
+	uint64 hash = Board.GetHash() ^ FColumnsZobrist::ProgressKey(Level, Jewels);
+	if (!bWithTrinities) return hash;
+
+	for (auto index = 0; index < CurrentSymbolIndicies.Num(); index++)
+	{
+		hash ^= FColumnsZobrist::PieceKey(0, index, CurrentSymbolIndicies[index]);
+	}
+
+	for (auto index = 0; index < NextSymbolIndicies.Num(); index++)
+	{
+		hash ^= FColumnsZobrist::PieceKey(1, index, NextSymbolIndicies[index]);
+	}
+
+	return hash;
+}
+
+int32 FColumnsGame::GetLandingRow(int32 column) const
+{
+	// check if at the bottom row or there's a symbol below
+	int32 row = LocationY;
+	while ((row + PAWN_SIZE) < Board.GetNumberOfRows() && Board.Get(row + PAWN_SIZE, column) == 0) row++;
+
+	return row;
+}
+
+bool FColumnsGame::IsColumnFree(int32 column) const
+{
+	for (auto row = LocationY; row < LocationY + PAWN_SIZE; row++)
+	{
+		if (Board.Get(row, column) != 0) return false;
+	}
+
+	return true;
+}
+
+bool FColumnsGame::IsTrinityBlocked() const
+{
+	// check if at the bottom row or there's a symbol below
+	return (LocationY + PAWN_SIZE) >= Board.GetNumberOfRows() || Board.Get(LocationY + PAWN_SIZE, LocationX) != 0;
+}
+
+void FColumnsGame::LandTrinity()
+{
+	if (PlaceTrinity()) FinishLanding(ResolveCascade());
+}
+
+bool FColumnsGame::PlacePiece(int32 column, int32 shuffleDowns)
+{
+	if (bGameOver || !CanReachColumn(column)) return false;
+
+	for (auto shuffle = 0; shuffle < shuffleDowns % PAWN_SIZE; shuffle++)
+	{
+		ApplyInput(EColumnsInput::SHUFFLE_DOWN);
+	}
+
+	LocationX = column;
+	LocationY = GetLandingRow(column);
+
+	PlaceTrinity();
+	return true;
+}
+
+bool FColumnsGame::PlaceTrinity()
+{
+	MoveDownHeld = false;
+	LastLandedColumn = LocationX;
+	LastLandedRow = LocationY;
+	LastLandedMs = PieceMs;
+	bBoardMovedOn = false;
+
+	// check for game over
+	if (LocationY < 0)
+	{
+		bGameOver = true;
+		return false;
+	}
+
+	Board.SetTrinity(CurrentSymbolIndicies, LocationY, LocationX);
+	PiecesPlaced++;
+	return true;
+}
+
+bool FColumnsGame::PrepareNextBoard(FColumnsNextBoard& outNextBoard) const
+{
+	if (Settings.IsEndless()) return false;
+
+	outNextBoard.Board.Init(Settings.NumberOfColumns, Settings.NumberOfRows, Settings.NumberOfSymbols);
+	outNextBoard.RowToStartRandomSymbols = Settings.GetRowToStartRandomSymbols(Level + 1);
+	outNextBoard.StartRandom = BoardRandom;
+	outNextBoard.Random = BoardRandom;
+
+	return true;
+}
+
+void FColumnsGame::Reset(const FColumnsGameSettings& inSettings, int32 seed)
+{
+	Settings = inSettings;
+	BoardRandom.Initialize((uint32)seed, COLUMNS_RANDOM_STREAM_BOARD);
+	PieceRandom.Initialize((uint32)seed, COLUMNS_RANDOM_STREAM_PIECES);
+
+	bGameOver = false;
+	PendingSeconds = 0.0f;
+	Level = Settings.StartLevel;
+	Score = 0;
+	TotalJewels = 0;
+	PiecesPlaced = 0;
+	LastCascadeDepth = 0;
+	MaxCascadeDepth = 0;
+	NextSymbolIndicies.Reset();
+	NextBoard = nullptr;
+
+	Cascade.Reserve(Settings.NumberOfColumns * Settings.NumberOfRows);
+
+	StartLevel();
+	SpawnTrinity();
+}
+
+int32 FColumnsGame::ResolveCascade()
+{
+	// the same cascade the game board plays back step by step, scored a step at a time
+	Cascade.Resolve(Board);
+
+	for (auto index = 0; index < Cascade.GetNumberOfSteps(); index++)
+	{
+		const int32 removed = Cascade.GetStep(index).NumberOfRemoved;
+		if (removed == 0) continue;
+
+		Jewels += removed;
+		TotalJewels += removed;
+		Score += ScoreForJewels(removed);
+	}
+
+	return Cascade.GetDepth();
+}
+
+bool FColumnsGame::RestoreSnapshot(const FColumnsSnapshot& snapshot)
+{
+	// the settings aren't in the snapshot
+	if (!snapshot.MatchesSettings(Settings)) return false;
+
+	snapshot.UnpackBoard(Board);
+	snapshot.GetTrinity(0, CurrentSymbolIndicies);
+	snapshot.GetTrinity(1, NextSymbolIndicies);
+	BoardRandom = snapshot.BoardRandom;
+	PieceRandom = snapshot.PieceRandom;
+	FallProgress = snapshot.FallProgress;
+	PendingSeconds = snapshot.PendingSeconds;
+	PieceMs = snapshot.PieceMs;
+	PiecesPlaced = snapshot.PiecesPlaced;
+	Score = snapshot.Score;
+	TotalJewels = snapshot.TotalJewels;
+	Level = snapshot.Level;
+	Jewels = snapshot.Jewels;
+	LastCascadeDepth = snapshot.LastCascadeDepth;
+	MaxCascadeDepth = snapshot.MaxCascadeDepth;
+	LocationX = snapshot.LocationX;
+	LocationY = snapshot.LocationY;
+	bGameOver = snapshot.bGameOver;
+	MoveDownHeld = snapshot.bMoveDownHeld;
+
+	// the gravity comes from the level, as starting the level sets it
+	GravityPixelsPerSecond = FMath::RoundToInt(Settings.GetGravityPixelsPerSecond(Level));
+
+	return true;
+}
+
+void FColumnsGame::SetNextBoard(FColumnsNextBoard* nextBoard)
+{
+	NextBoard = nextBoard;
+	NextBoardGame = this;
+}
+
+void FColumnsGame::SetPosition(const FColumnsBoard& inBoard, int32 locationX, int32 locationY)
+{
+	Board = inBoard;
+	LocationX = locationX;
+	LocationY = locationY;
+	FallProgress = 0;
+	MoveDownHeld = false;
+}
+
+void FColumnsGame::SetTrinities(const TArray<int32>& currentSymbolIndicies, const TArray<int32>& nextSymbolIndicies)
+{
+	CurrentSymbolIndicies = currentSymbolIndicies;
+	NextSymbolIndicies = nextSymbolIndicies;
+}
+
+void FColumnsGame::SpawnTrinity()
+{
+	// reset location
+	LocationX = 0;
+	LocationY = -PAWN_SIZE;
+	FallProgress = 0;
+	PieceMs = 0;
+	MoveDownHeld = false;
+
+	// if the next symbols have already been created, use them; copied into the existing allocation
+	CurrentSymbolIndicies.Reset();
+	if (NextSymbolIndicies.Num() > 0)
+	{
+		CurrentSymbolIndicies.Append(NextSymbolIndicies);
+	}
+	else
+	{
+		for (auto index = 0; index < PAWN_SIZE; index++)
+		{
+			CurrentSymbolIndicies.Add(PieceRandom.RandRange(0, Board.GetNumberOfSymbols() - 1));
+		}
+	}
+
+	NextSymbolIndicies.Reset();
+	for (auto index = 0; index < PAWN_SIZE; index++)
+	{
+		NextSymbolIndicies.Add(PieceRandom.RandRange(0, Board.GetNumberOfSymbols() - 1));
+	}
+}
+
+void FColumnsGame::StartLevel()
+{
+	Jewels = 0;
+	GravityPixelsPerSecond = FMath::RoundToInt(Settings.GetGravityPixelsPerSecond(Level));
+
+	// an endless board carries on from level to level; it's only constructed when the game starts
+	if (Settings.IsEndless() && PiecesPlaced > 0) return;
+
+	// only take the board filled ahead of time if filling one here would make the same board
+	const int32 rowToStartRandomSymbols = Settings.GetRowToStartRandomSymbols(Level);
+	if (NextBoard != nullptr && NextBoardGame == this && NextBoard->Board.GetNumberOfColumns() == Settings.NumberOfColumns
+		&& NextBoard->Board.GetNumberOfRows() == Settings.NumberOfRows && NextBoard->Board.GetNumberOfSymbols() == Settings.NumberOfSymbols
+		&& NextBoard->RowToStartRandomSymbols == rowToStartRandomSymbols && NextBoard->StartRandom == BoardRandom)
+	{
+		Board = MoveTemp(NextBoard->Board);
+		BoardRandom = NextBoard->Random;
+	}
+	else
+	{
+		Board.Init(Settings.NumberOfColumns, Settings.NumberOfRows, Settings.NumberOfSymbols);
+		Board.Construct(rowToStartRandomSymbols, BoardRandom);
+	}
+
+	NextBoard = nullptr;
+	bBoardMovedOn = true;
+}
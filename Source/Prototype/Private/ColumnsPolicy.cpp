@@ -0,0 +1,215 @@
+// Copyright 2019
+#include "ColumnsPolicy.h"
+#include "BoardBatchKernel.h"
+#include "ColumnsSearch.h"
+
+// Try every column and shuffle of the trinity on a batch of boards, one placement a lane, and keep the one
+// whose cascade collects the most jewels, keeping the settled stack low on ties. Only the cascade is run,
+// so unlike a copy of the game, a placement that finishes the level is valued on the board it settles.
+static FColumnsPlacement ChooseGreedyPlacementBatched(const FColumnsGame& game)
+{
+	const FColumnsBoard& board = game.GetBoard();
+	const int32 numberOfColumns = board.GetNumberOfColumns();
+	const int32 numberOfRows = board.GetNumberOfRows();
+
+	// a batch per thread, as games are usually played in parallel; only sized again for another board
+	static thread_local FBoardBatch batch;
+	if (batch.GetNumberOfColumns() != numberOfColumns || batch.GetNumberOfRows() != numberOfRows) batch.Init(numberOfColumns, numberOfRows);
+
+	FColumnsPlacement best;
+	int32 bestValue = MIN_int32;
+
+	FColumnsPlacement placements[BOARD_BATCH_LANES];
+	int32 numberOfLanes = 0;
+	int32 jewels[BOARD_BATCH_LANES];
+	int32 depth[BOARD_BATCH_LANES];
+
+	const TArray<int32>& symbolIndicies = game.GetCurrentSymbolIndicies();
+	const int32 numberOfPlacements = numberOfColumns * PAWN_SIZE;
+	for (auto index = 0; index <= numberOfPlacements; index++)
+	{
+		// fill the lanes in the order the placements are valued, so ties go the same way as one at a time
+		if (index < numberOfPlacements)
+		{
+			FColumnsPlacement placement;
+			placement.Column = index / PAWN_SIZE;
+			placement.ShuffleDowns = index % PAWN_SIZE;
+
+			const int32 row = game.GetLandingRow(placement.Column);
+			if (game.CanReachColumn(placement.Column) && row >= 0)
+			{
+				// a shuffle down moves the last symbol to the top
+				batch.LoadBoard(numberOfLanes, board);
+				for (auto symbol = 0; symbol < PAWN_SIZE; symbol++)
+				{
+					batch.Set(numberOfLanes, row + symbol, placement.Column, symbolIndicies[(symbol - placement.ShuffleDowns + PAWN_SIZE) % PAWN_SIZE] + 1);
+				}
+
+				placements[numberOfLanes++] = placement;
+			}
+
+			if (numberOfLanes < BOARD_BATCH_LANES) continue;
+		}
+
+		if (numberOfLanes == 0) continue;
+
+		// the lanes left over from the last batch have settled, so they only cost the time of a lane
+		batch.ResolveCascade(jewels, depth);
+
+		for (auto lane = 0; lane < numberOfLanes; lane++)
+		{
+			int32 stackHeight = 0;
+			for (auto cell = 0; cell < numberOfColumns * numberOfRows && stackHeight == 0; cell++)
+			{
+				if (batch.Get(lane, cell / numberOfColumns, cell % numberOfColumns) != 0) stackHeight = numberOfRows - cell / numberOfColumns;
+			}
+
+			const int32 value = jewels[lane] * numberOfRows - stackHeight;
+			if (value > bestValue)
+			{
+				bestValue = value;
+				best = placements[lane];
+			}
+		}
+
+		numberOfLanes = 0;
+	}
+
+	return best;
+}
+
+FColumnsPlacement FColumnsPolicy::ChoosePlacement(EColumnsPolicy policy, const FColumnsGame& game, FColumnsRandom& random)
+{
+	const FColumnsBoard& board = game.GetBoard();
+	FColumnsPlacement best;
+
+	if (policy == EColumnsPolicy::RANDOM)
+	{
+		best.Column = random.RandRange(0, board.GetNumberOfColumns() - 1);
+		best.ShuffleDowns = random.RandRange(0, PAWN_SIZE - 1);
+		return best;
+	}
+
+	if (policy == EColumnsPolicy::SEARCH)
+	{
+		// games are usually played in parallel already, so search each one on its own thread
+		FColumnsSearchSettings settings;
+		settings.MaxDepth = 2;
+		settings.BudgetSeconds = 0.0;
+		settings.bParallel = false;
+
+		// a value in the table is the same whichever game stored it, so each thread keeps one
+		static thread_local FColumnsTranspositionTable table(14);
+
+		return FColumnsSearch(settings, &table).Search(game, random.Next()).Placement;
+	}
+
+	if (FBoardBatch::Fits(board.GetNumberOfColumns(), board.GetNumberOfRows(), board.GetNumberOfSymbols()))
+	{
+		return ChooseGreedyPlacementBatched(game);
+	}
+
+	// try every column and shuffle on a copy of the game and keep the best result
+	int32 bestValue = MIN_int32;
+	for (auto column = 0; column < board.GetNumberOfColumns(); column++)
+	{
+		for (auto shuffleDowns = 0; shuffleDowns < PAWN_SIZE; shuffleDowns++)
+		{
+			FColumnsGame trial = game;
+			if (!trial.DropPiece(column, shuffleDowns) || trial.IsGameOver()) continue;
+
+			const int32 jewels = trial.GetTotalJewels() - game.GetTotalJewels();
+			const int32 value = jewels * board.GetNumberOfRows() - GetStackHeight(trial.GetBoard());
+			if (value > bestValue)
+			{
+				bestValue = value;
+				best.Column = column;
+				best.ShuffleDowns = shuffleDowns;
+			}
+		}
+	}
+
+	return best;
+}
+
+int32 FColumnsPolicy::GetStackHeight(const FColumnsBoard& board)
+{
+	for (auto row = 0; row < board.GetNumberOfRows(); row++)
+	{
+		for (auto column = 0; column < board.GetNumberOfColumns(); column++)
+		{
+			if (board.Get(row, column) != 0) return board.GetNumberOfRows() - row;
+		}
+	}
+
+	return 0;
+}
+
+bool FColumnsPolicy::Parse(const FString& name, EColumnsPolicy& outPolicy)
+{
+	if (name.Equals(TEXT("random"), ESearchCase::IgnoreCase))
+	{
+		outPolicy = EColumnsPolicy::RANDOM;
+		return true;
+	}
+
+	if (name.Equals(TEXT("greedy"), ESearchCase::IgnoreCase))
+	{
+		outPolicy = EColumnsPolicy::GREEDY;
+		return true;
+	}
+
+	if (name.Equals(TEXT("search"), ESearchCase::IgnoreCase))
+	{
+		outPolicy = EColumnsPolicy::SEARCH;
+		return true;
+	}
+
+	return false;
+}
+
+void FColumnsPolicy::PlayGame(FColumnsGame& game, EColumnsPolicy policy, FColumnsRandom& random, float inputIntervalSeconds, int32 maxPieces)
+{
+	int32 plannedPiece = -1;
+	int32 shuffleDownsLeft = 0;
+	FColumnsPlacement target;
+
+	while (!game.IsGameOver() && game.GetPiecesPlaced() < maxPieces)
+	{
+		// plan once per trinity
+		if (plannedPiece != game.GetPiecesPlaced())
+		{
+			target = ChoosePlacement(policy, game, random);
+			shuffleDownsLeft = target.ShuffleDowns;
+			plannedPiece = game.GetPiecesPlaced();
+		}
+
+		if (inputIntervalSeconds <= 0.0f)
+		{
+			// drop straight in; if the column can't be reached, drop where it is
+			if (!game.DropPiece(target.Column, target.ShuffleDowns)) game.DropPiece(game.GetLocationX(), 0);
+			continue;
+		}
+
+		// shuffle first, then move across, then hold down
+		if (shuffleDownsLeft > 0)
+		{
+			game.ApplyInput(EColumnsInput::SHUFFLE_DOWN);
+			shuffleDownsLeft--;
+		}
+		else if (target.Column < game.GetLocationX())
+		{
+			game.ApplyInput(EColumnsInput::MOVE_LEFT);
+		}
+		else if (target.Column > game.GetLocationX())
+		{
+			game.ApplyInput(EColumnsInput::MOVE_RIGHT);
+		}
+		else
+		{
+			game.ApplyInput(EColumnsInput::MOVE_DOWN_PRESSED);
+		}
+
+		game.Advance(inputIntervalSeconds);
+	}
+}
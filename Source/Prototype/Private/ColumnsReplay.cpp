@@ -0,0 +1,204 @@
+// Copyright 2019
+#include "ColumnsReplay.h"
+
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+// How long a trinity may keep falling past its recorded landing, for recordings timed by frames.
+constexpr int32 COLUMNS_REPLAY_SETTLE_MS = 1000;
+
+// Append an unsigned integer 7 bits at a time, low bits first; small values take one byte.
+static void WriteVarInt(TArray<uint8>& bytes, uint32 value)
+{
+	while (value >= 0x80)
+	{
+		bytes.Add((uint8)(value | 0x80));
+		value >>= 7;
+	}
+	bytes.Add((uint8)value);
+}
+
+// Read an integer written by write var int; false if the bytes run out.
+static bool ReadVarInt(const TArray<uint8>& bytes, int32& offset, uint32& outValue)
+{
+	outValue = 0;
+	for (int32 shift = 0; shift < 35; shift += 7)
+	{
+		if (offset >= bytes.Num()) return false;
+
+		const uint8 byte = bytes[offset++];
+		outValue |= (uint32)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) return true;
+	}
+
+	return false;
+}
+
+void FColumnsReplay::Begin(int32 inSeed, const FColumnsGameSettings& inSettings)
+{
+	Seed = inSeed;
+	Settings = inSettings;
+	Events.Reset();
+}
+
+bool FColumnsReplay::LoadFromFile(const FString& filename)
+{
+	TArray<uint8> bytes;
+	if (!FFileHelper::LoadFileToArray(bytes, *filename)) return false;
+
+	FMemoryReader reader(bytes);
+	Serialize(reader);
+	return !reader.IsError();
+}
+
+bool FColumnsReplay::Play(FColumnsGame& game, FString& outError) const
+{
+	game.Reset(Settings, Seed);
+
+	for (auto index = 0; index < Events.Num(); index++)
+	{
+		const FColumnsReplayEvent& event = Events[index];
+		const int32 piece = game.GetPiecesPlaced();
+
+		// run the trinity forward to the time of the event
+		const int32 deltaMs = (int32)event.TimeMs - game.GetPieceMs();
+		if (deltaMs > 0) game.AdvanceMs(deltaMs);
+
+		const bool landed = game.IsGameOver() || game.GetPiecesPlaced() != piece;
+
+		if (event.Type == COLUMNS_REPLAY_LANDED)
+		{
+			// a recording timed by frames may land a little before the rules would
+			if (!landed) game.AdvanceMs(COLUMNS_REPLAY_SETTLE_MS);
+
+			if (game.GetLastLandedColumn() != event.Column || game.GetLastLandedRow() != event.Row)
+			{
+				outError = FString::Printf(TEXT("Trinity %d landed at column %d row %d, recorded at column %d row %d."),
+					piece, game.GetLastLandedColumn(), game.GetLastLandedRow(), event.Column, event.Row);
+				return false;
+			}
+		}
+		else if (landed)
+		{
+			outError = FString::Printf(TEXT("Trinity %d landed before recorded input %d at %u ms."), piece, index, event.TimeMs);
+			return false;
+		}
+		else
+		{
+			game.ApplyInput((EColumnsInput)event.Type);
+		}
+	}
+
+	return true;
+}
+
+void FColumnsReplay::RecordInput(EColumnsInput input, int32 pieceMs)
+{
+	FColumnsReplayEvent event;
+	event.Type = (uint8)input;
+	event.TimeMs = (uint32)FMath::Max(0, pieceMs);
+	Events.Add(event);
+}
+
+void FColumnsReplay::RecordLanded(int32 pieceMs, int32 column, int32 row)
+{
+	FColumnsReplayEvent event;
+	event.Type = COLUMNS_REPLAY_LANDED;
+	event.TimeMs = (uint32)FMath::Max(0, pieceMs);
+	event.Column = (int8)column;
+	event.Row = (int8)row;
+	Events.Add(event);
+}
+
+void FColumnsReplay::RewindEvents(int32 numberOfEvents)
+{
+	if (numberOfEvents >= 0 && numberOfEvents < Events.Num()) Events.SetNum(numberOfEvents);
+}
+
+bool FColumnsReplay::SaveToFile(const FString& filename)
+{
+	TArray<uint8> bytes;
+	FMemoryWriter writer(bytes);
+	Serialize(writer);
+
+	return !writer.IsError() && FFileHelper::SaveArrayToFile(bytes, *filename);
+}
+
+void FColumnsReplay::Serialize(FArchive& archive)
+{
+	uint32 magic = COLUMNS_REPLAY_MAGIC;
+	uint16 version = COLUMNS_REPLAY_VERSION;
+	archive << magic << version;
+
+	if (archive.IsLoading() && (magic != COLUMNS_REPLAY_MAGIC || version != COLUMNS_REPLAY_VERSION))
+	{
+		archive.SetError();
+		return;
+	}
+
+	archive << Seed;
+	archive << Settings.NumberOfColumns << Settings.NumberOfRows << Settings.NumberOfSymbols;
+	archive << Settings.StartLevel << Settings.JewelsRequired;
+	archive << Settings.FilledRowsBase << Settings.FilledRowsPerLevel;
+	archive << Settings.GravityPixelsPerSecond << Settings.GravityLevelScale;
+	archive << Settings.EndlessRows << Settings.EndlessChunkRows << Settings.EndlessEmptyRows;
+
+	// events are packed as a type byte and the time since the previous event of the same trinity
+	TArray<uint8> packed;
+	if (archive.IsSaving())
+	{
+		uint32 previousTimeMs = 0;
+		for (const FColumnsReplayEvent& event : Events)
+		{
+			packed.Add(event.Type);
+			WriteVarInt(packed, event.TimeMs >= previousTimeMs ? event.TimeMs - previousTimeMs : 0);
+			previousTimeMs = event.TimeMs;
+
+			if (event.Type == COLUMNS_REPLAY_LANDED)
+			{
+				packed.Add((uint8)event.Column);
+				packed.Add((uint8)event.Row);
+				previousTimeMs = 0;
+			}
+		}
+	}
+
+	archive << packed;
+
+	if (archive.IsLoading())
+	{
+		Events.Reset();
+
+		uint32 previousTimeMs = 0;
+		int32 offset = 0;
+		while (offset < packed.Num())
+		{
+			FColumnsReplayEvent event;
+			event.Type = packed[offset++];
+
+			uint32 deltaMs;
+			if (!ReadVarInt(packed, offset, deltaMs))
+			{
+				archive.SetError();
+				return;
+			}
+			event.TimeMs = previousTimeMs + deltaMs;
+			previousTimeMs = event.TimeMs;
+
+			if (event.Type == COLUMNS_REPLAY_LANDED)
+			{
+				if (offset + 2 > packed.Num())
+				{
+					archive.SetError();
+					return;
+				}
+				event.Column = (int8)packed[offset++];
+				event.Row = (int8)packed[offset++];
+				previousTimeMs = 0;
+			}
+
+			Events.Add(event);
+		}
+	}
+}
@@ -0,0 +1,83 @@
+// Copyright 2019
+#include "ColumnsReplayCommandlet.h"
+
+#include "ColumnsReplay.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+#include "Prototype.h"
+
+UColumnsReplayCommandlet::UColumnsReplayCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UColumnsReplayCommandlet::Main(const FString& Params)
+{
+	FString replayPath = FPaths::ProjectSavedDir() / TEXT("Replays");
+	int32 repeat = 1;
+
+	FParse::Value(*Params, TEXT("replay="), replayPath);
+	FParse::Value(*Params, TEXT("repeat="), repeat);
+	repeat = FMath::Max(1, repeat);
+
+	TArray<FString> filenames;
+	if (IFileManager::Get().DirectoryExists(*replayPath))
+	{
+		IFileManager::Get().FindFiles(filenames, *(replayPath / TEXT("*.replay")), true, false);
+		for (FString& filename : filenames)
+		{
+			filename = replayPath / filename;
+		}
+	}
+	else
+	{
+		filenames.Add(replayPath);
+	}
+
+	if (filenames.Num() == 0)
+	{
+		UE_LOG(LogColumns, Error, TEXT("No replays found at %s."), *replayPath);
+		return 1;
+	}
+
+	int32 failed = 0;
+	for (const FString& filename : filenames)
+	{
+		FColumnsReplay replay;
+		if (!replay.LoadFromFile(filename))
+		{
+			UE_LOG(LogColumns, Error, TEXT("%s: not a replay."), *filename);
+			failed++;
+			continue;
+		}
+
+		FColumnsGame game;
+		FString error;
+		bool bPassed = true;
+
+		const double startSeconds = FPlatformTime::Seconds();
+		for (auto index = 0; index < repeat && bPassed; index++)
+		{
+			bPassed = replay.Play(game, error);
+		}
+		const double elapsedSeconds = FPlatformTime::Seconds() - startSeconds;
+
+		if (bPassed)
+		{
+			UE_LOG(LogColumns, Display, TEXT("%s: passed, %d events, %d trinities, score %d, %.3f ms per play."),
+				*filename, replay.GetEvents().Num(), game.GetPiecesPlaced(), game.GetScore(), elapsedSeconds * 1000.0 / repeat);
+		}
+		else
+		{
+			UE_LOG(LogColumns, Error, TEXT("%s: failed. %s"), *filename, *error);
+			failed++;
+		}
+	}
+
+	UE_LOG(LogColumns, Display, TEXT("%d of %d replays passed."), filenames.Num() - failed, filenames.Num());
+	return failed > 0 ? 1 : 0;
+}
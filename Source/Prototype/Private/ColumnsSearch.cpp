@@ -0,0 +1,207 @@
+// Copyright 2019
+#include "ColumnsSearch.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+
+// The value of a placement that ends the game.
+constexpr int32 COLUMNS_SEARCH_LOSS_VALUE = -1000000;
+
+// Tags the hash of a position whose trinities are sampled rather than known.
+constexpr int32 COLUMNS_SEARCH_SAMPLED_TAG = 1;
+
+// Tags the key of the seed a search samples its pieces with.
+constexpr int32 COLUMNS_SEARCH_SEED_TAG = 2;
+
+FColumnsSearch::FColumnsSearch(const FColumnsSearchSettings& inSettings, FColumnsTranspositionTable* inTable)
+	: Settings(inSettings), Table(inTable)
+{
+}
+
+int32 FColumnsSearch::Evaluate(const FColumnsGame& root, const FColumnsGame& game)
+{
+	if (game.IsGameOver()) return COLUMNS_SEARCH_LOSS_VALUE;
+
+	return EvaluateGain(root, game) + EvaluateBoard(game);
+}
+
+int32 FColumnsSearch::EvaluateBoard(const FColumnsGame& game)
+{
+	if (game.IsGameOver()) return COLUMNS_SEARCH_LOSS_VALUE;
+
+	const FColumnsBoard& board = game.GetBoard();
+	const int32 rows = board.GetNumberOfRows();
+
+	// the trinity enters at the first column, so once that column is over half full every symbol counts
+	const int32 danger = FMath::Max(0, GetColumnHeight(board, 0) - rows / 2);
+
+	return -FColumnsPolicy::GetStackHeight(board) * 2 - danger * danger * rows;
+}
+
+int32 FColumnsSearch::EvaluateGain(const FColumnsGame& from, const FColumnsGame& to)
+{
+	const int32 jewels = to.GetTotalJewels() - from.GetTotalJewels();
+	const int32 score = to.GetScore() - from.GetScore();
+
+	return jewels * from.GetBoard().GetNumberOfRows() + score;
+}
+
+int32 FColumnsSearch::GetColumnHeight(const FColumnsBoard& board, int32 column)
+{
+	for (auto row = 0; row < board.GetNumberOfRows(); row++)
+	{
+		if (board.Get(row, column) != 0) return board.GetNumberOfRows() - row;
+	}
+
+	return 0;
+}
+
+FColumnsSearchResult FColumnsSearch::Search(const FColumnsGame& game, uint32 seed) const
+{
+	FColumnsSearchResult result;
+	const double deadlineSeconds = Settings.BudgetSeconds > 0.0 ? FPlatformTime::Seconds() + Settings.BudgetSeconds : 0.0;
+
+	// every placement of the falling trinity that can be reached
+	TArray<FColumnsPlacement> placements;
+	TArray<FColumnsGame> trials;
+	for (auto column = 0; column < game.GetBoard().GetNumberOfColumns(); column++)
+	{
+		for (auto shuffleDowns = 0; shuffleDowns < PAWN_SIZE; shuffleDowns++)
+		{
+			FColumnsGame trial = game;
+			if (!trial.DropPiece(column, shuffleDowns)) continue;
+
+			FColumnsPlacement placement;
+			placement.Column = column;
+			placement.ShuffleDowns = shuffleDowns;
+			placements.Add(placement);
+			trials.Add(trial);
+		}
+	}
+
+	result.Placement.Column = game.GetLocationX();
+	result.Nodes = placements.Num();
+	if (placements.Num() == 0) return result;
+
+	// look one more piece ahead each pass, keeping the last pass that finished in time
+	TArray<int32> values;
+	values.SetNum(placements.Num());
+
+	for (auto depth = 1; depth <= FMath::Max(1, Settings.MaxDepth); depth++)
+	{
+		FThreadSafeBool bOutOfTime;
+		FThreadSafeCounter nodes;
+		FThreadSafeCounter tableHits;
+
+		ParallelFor(placements.Num(), [&](int32 index)
+		{
+			const FColumnsGame& trial = trials[index];
+			if (depth == 1 || trial.IsGameOver())
+			{
+				values[index] = Evaluate(game, trial);
+				return;
+			}
+
+			values[index] = EvaluateGain(game, trial) + SearchPiece(trial, 1, depth - 1, seed, deadlineSeconds, bOutOfTime, nodes, tableHits);
+		}, !Settings.bParallel);
+
+		result.Nodes += nodes.GetValue();
+		result.TableHits += tableHits.GetValue();
+
+		// a pass cut short has only looked at some of the placements
+		if (bOutOfTime && depth > 1) break;
+
+		int32 best = 0;
+		for (auto index = 1; index < values.Num(); index++)
+		{
+			if (values[index] > values[best]) best = index;
+		}
+
+		result.Placement = placements[best];
+		result.Value = values[best];
+		result.Depth = depth;
+
+		if (bOutOfTime) break;
+	}
+
+	return result;
+}
+
+int32 FColumnsSearch::SearchPiece(const FColumnsGame& game, int32 depthIndex, int32 depth, uint32 seed,
+	double deadlineSeconds, FThreadSafeBool& bOutOfTime, FThreadSafeCounter& nodes, FThreadSafeCounter& tableHits) const
+{
+	const bool bCancelled = Settings.Cancel != nullptr && *Settings.Cancel;
+	if (bCancelled || (deadlineSeconds > 0.0 && (bOutOfTime || FPlatformTime::Seconds() > deadlineSeconds)))
+	{
+		bOutOfTime = true;
+		return 0;
+	}
+
+	// the same position is often reached by different placements; the seed is part of the key, as the
+	// pieces sampled below a position depend on it
+	const bool bSampled = depthIndex >= 2;
+	const uint64 key = (bSampled ? game.GetHash(false) ^ FColumnsZobrist::TagKey(COLUMNS_SEARCH_SAMPLED_TAG) : game.GetHash())
+		^ FColumnsZobrist::Mix(FColumnsZobrist::TagKey(COLUMNS_SEARCH_SEED_TAG) ^ seed);
+
+	int32 cachedValue;
+	if (Table != nullptr && Table->Probe(key, depth, cachedValue))
+	{
+		tableHits.Increment();
+		return cachedValue;
+	}
+
+	int32 value = COLUMNS_SEARCH_LOSS_VALUE;
+
+	// past the next trinity the pieces aren't known, so average over some random ones, drawn from the
+	// position itself so its value is the same whichever path or thread reaches it first
+	if (bSampled)
+	{
+		FColumnsRandom random(seed, key);
+
+		const int32 samples = FMath::Max(1, Settings.Samples);
+		const int32 numberOfSymbols = game.GetBoard().GetNumberOfSymbols();
+
+		int64 total = 0;
+		for (auto sample = 0; sample < samples; sample++)
+		{
+			TArray<int32> symbolIndicies;
+			for (auto index = 0; index < PAWN_SIZE; index++)
+			{
+				symbolIndicies.Add(random.RandRange(0, numberOfSymbols - 1));
+			}
+
+			FColumnsGame sampled = game;
+			sampled.SetTrinities(symbolIndicies, game.GetNextSymbolIndicies());
+			total += SearchPiece(sampled, 1, depth, seed, deadlineSeconds, bOutOfTime, nodes, tableHits);
+		}
+
+		value = (int32)(total / samples);
+	}
+	else
+	{
+		for (auto column = 0; column < game.GetBoard().GetNumberOfColumns(); column++)
+		{
+			for (auto shuffleDowns = 0; shuffleDowns < PAWN_SIZE; shuffleDowns++)
+			{
+				FColumnsGame trial = game;
+				if (!trial.DropPiece(column, shuffleDowns)) continue;
+				nodes.Increment();
+
+				int32 trialValue = COLUMNS_SEARCH_LOSS_VALUE;
+				if (!trial.IsGameOver())
+				{
+					trialValue = EvaluateGain(game, trial) + (depth <= 1
+						? EvaluateBoard(trial)
+						: SearchPiece(trial, depthIndex + 1, depth - 1, seed, deadlineSeconds, bOutOfTime, nodes, tableHits));
+				}
+
+				value = FMath::Max(value, trialValue);
+			}
+		}
+	}
+
+	// a search cut short by the deadline isn't worth keeping
+	if (Table != nullptr && !bOutOfTime) Table->Store(key, depth, value);
+
+	return value;
+}
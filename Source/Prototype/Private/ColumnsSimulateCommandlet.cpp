@@ -0,0 +1,125 @@
+// Copyright 2019
+#include "ColumnsSimulateCommandlet.h"
+
+#include "Async/ParallelFor.h"
+#include "BoardBatchKernel.h"
+#include "ColumnsCommandletHelpers.h"
+#include "ColumnsGame.h"
+#include "ColumnsPolicy.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+#include "Prototype.h"
+
+// The totals of one simulated game.
+struct FColumnsGameResult
+{
+	int32 Level = 0;
+	int32 Score = 0;
+	int32 Pieces = 0;
+	int32 Jewels = 0;
+	int32 MaxCascadeDepth = 0;
+	bool bGameOver = false;
+};
+
+UColumnsSimulateCommandlet::UColumnsSimulateCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UColumnsSimulateCommandlet::Main(const FString& Params)
+{
+	int32 games = 1000;
+	int32 seed = 1;
+	int32 maxPieces = 5000;
+	float inputIntervalSeconds = GAME_BOARD_SPACING / PAWN_SPEED_PIXELS_PER_SECOND;
+	FString policyName = TEXT("greedy");
+	FString outputPath = FPaths::ProjectSavedDir() / TEXT("ColumnsSimulate.csv");
+
+	FParse::Value(*Params, TEXT("games="), games);
+	FParse::Value(*Params, TEXT("seed="), seed);
+	FParse::Value(*Params, TEXT("maxpieces="), maxPieces);
+	FParse::Value(*Params, TEXT("inputinterval="), inputIntervalSeconds);
+	FParse::Value(*Params, TEXT("policy="), policyName);
+	FParse::Value(*Params, TEXT("output="), outputPath);
+	if (FParse::Param(*Params, TEXT("instant"))) inputIntervalSeconds = 0.0f;
+
+	FColumnsGameSettings settings;
+	FColumnsCommandletHelpers::ParseSettings(Params, settings);
+
+	EColumnsPolicy policy;
+	if (!FColumnsPolicy::Parse(policyName, policy))
+	{
+		UE_LOG(LogColumns, Error, TEXT("Unknown policy '%s'; use random, greedy or search."), *policyName);
+		return 1;
+	}
+
+	if (games <= 0 || settings.NumberOfColumns <= 0 || settings.NumberOfRows <= PAWN_SIZE || settings.NumberOfSymbols <= 0)
+	{
+		UE_LOG(LogColumns, Error, TEXT("Nothing to simulate; check -games, -columns, -rows and -symbols."));
+		return 1;
+	}
+
+	if (policy == EColumnsPolicy::GREEDY && FBoardBatch::Fits(settings.NumberOfColumns, settings.NumberOfRows, settings.NumberOfSymbols))
+	{
+		UE_LOG(LogColumns, Display, TEXT("Greedy placements are valued with the %s batch kernel."), FBoardBatchKernel::Best().Name);
+	}
+
+	// every game is independent and seeded from its index, so results don't depend on the thread count
+	TArray<FColumnsGameResult> results;
+	results.SetNum(games);
+
+	const double startSeconds = FPlatformTime::Seconds();
+
+	ParallelFor(games, [&](int32 gameIndex)
+	{
+		FColumnsGame game;
+		game.Reset(settings, seed + gameIndex);
+
+		FColumnsRandom policyRandom(seed + gameIndex);
+		FColumnsPolicy::PlayGame(game, policy, policyRandom, inputIntervalSeconds, maxPieces);
+
+		FColumnsGameResult& result = results[gameIndex];
+		result.Level = game.GetLevel();
+		result.Score = game.GetScore();
+		result.Pieces = game.GetPiecesPlaced();
+		result.Jewels = game.GetTotalJewels();
+		result.MaxCascadeDepth = game.GetMaxCascadeDepth();
+		result.bGameOver = game.IsGameOver();
+	});
+
+	const double elapsedSeconds = FPlatformTime::Seconds() - startSeconds;
+
+	// aggregate
+	int32 survived = 0;
+	int32 maxLevel = 0;
+	double totalLevel = 0.0, totalScore = 0.0, totalPieces = 0.0, totalJewels = 0.0, totalMaxCascadeDepth = 0.0;
+	for (const FColumnsGameResult& result : results)
+	{
+		if (!result.bGameOver) survived++;
+		maxLevel = FMath::Max(maxLevel, result.Level);
+		totalLevel += result.Level;
+		totalScore += result.Score;
+		totalPieces += result.Pieces;
+		totalJewels += result.Jewels;
+		totalMaxCascadeDepth += result.MaxCascadeDepth;
+	}
+
+	const double gamesPerSecond = elapsedSeconds > 0.0 ? games / elapsedSeconds : 0.0;
+
+	UE_LOG(LogColumns, Display, TEXT("Simulated %d games in %.3f s (%.0f games/s): mean level %.2f, mean score %.1f, mean pieces %.1f, %d survived %d pieces."),
+		games, elapsedSeconds, gamesPerSecond, totalLevel / games, totalScore / games, totalPieces / games, survived, maxPieces);
+
+	// append a row per run so a sweep of settings ends up in one file
+	const FString header = TEXT("Games,Policy,Seed,MaxPieces,InputInterval,") + FColumnsCommandletHelpers::GetSettingsCsvHeader()
+		+ TEXT(",Survived,MeanLevel,MaxLevel,MeanScore,MeanPieces,MeanJewels,MeanMaxCascadeDepth,Seconds,GamesPerSecond");
+
+	const FString row = FString::Printf(TEXT("%d,%s,%d,%d,%f,"), games, *policyName.ToLower(), seed, maxPieces, inputIntervalSeconds)
+		+ FColumnsCommandletHelpers::GetSettingsCsvValues(settings)
+		+ FString::Printf(TEXT(",%d,%f,%d,%f,%f,%f,%f,%f,%f\n"), survived, totalLevel / games, maxLevel, totalScore / games,
+			totalPieces / games, totalJewels / games, totalMaxCascadeDepth / games, elapsedSeconds, gamesPerSecond);
+
+	return FColumnsCommandletHelpers::AppendCsv(outputPath, header, row) ? 0 : 1;
+}
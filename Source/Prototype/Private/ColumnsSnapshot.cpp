@@ -0,0 +1,162 @@
+// Copyright 2019
+#include "ColumnsSnapshot.h"
+
+#include "Async/MappedFileHandle.h"
+#include "ColumnsGame.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+
+// The start of a save file; the sizes tell apart saves written by a build with another layout.
+struct FColumnsSaveHeader
+{
+	uint32 Magic = COLUMNS_SAVE_MAGIC;
+	uint32 Version = COLUMNS_SAVE_VERSION;
+	uint32 SettingsSize = sizeof(FColumnsGameSettings);
+	uint32 SnapshotSize = sizeof(FColumnsSnapshot);
+	int32 Seed = 0;
+};
+
+// The symbol index bits of one trinity symbol in a snapshot.
+constexpr int32 COLUMNS_SNAPSHOT_SYMBOL_BITS = 4;
+
+int32 FColumnsSnapshot::GetBitsPerCell(int32 numberOfSymbols)
+{
+	if (numberOfSymbols < 8) return 3;
+	if (numberOfSymbols < 16) return 4;
+
+	return 0;
+}
+
+void FColumnsSnapshot::GetTrinity(int32 trinity, TArray<int32>& outSymbolIndicies) const
+{
+	outSymbolIndicies.Reset();
+	for (auto index = 0; index < PAWN_SIZE; index++)
+	{
+		const int32 shift = (trinity * PAWN_SIZE + index) * COLUMNS_SNAPSHOT_SYMBOL_BITS;
+		outSymbolIndicies.Add((int32)((Trinities >> shift) & ((1u << COLUMNS_SNAPSHOT_SYMBOL_BITS) - 1)));
+	}
+}
+
+bool FColumnsSnapshot::MatchesSettings(const FColumnsGameSettings& settings) const
+{
+	return NumberOfColumns == settings.NumberOfColumns && NumberOfRows == settings.NumberOfRows
+		&& NumberOfSymbols == settings.NumberOfSymbols;
+}
+
+bool FColumnsSnapshot::PackBoard(const FColumnsBoard& board)
+{
+	const int32 bitsPerCell = GetBitsPerCell(board.GetNumberOfSymbols());
+	if (bitsPerCell == 0 || board.GetNumberOfColumns() > MAX_int8 || board.GetNumberOfRows() > MAX_uint16) return false;
+
+	const int32 cellsPerWord = 64 / bitsPerCell;
+	if (board.GetNumberOfColumns() * board.GetNumberOfRows() > COLUMNS_SNAPSHOT_CELL_WORDS * cellsPerWord) return false;
+
+	NumberOfColumns = (uint8)board.GetNumberOfColumns();
+	NumberOfRows = (uint16)board.GetNumberOfRows();
+	NumberOfSymbols = (uint8)board.GetNumberOfSymbols();
+	BitsPerCell = (uint8)bitsPerCell;
+	FirstRow = board.GetFirstRow();
+
+	board.Pack(Cells, bitsPerCell);
+	return true;
+}
+
+void FColumnsSnapshot::SetTrinities(const TArray<int32>& currentSymbolIndicies, const TArray<int32>& nextSymbolIndicies)
+{
+	Trinities = 0;
+	for (auto index = 0; index < PAWN_SIZE; index++)
+	{
+		if (index < currentSymbolIndicies.Num()) Trinities |= (uint32)currentSymbolIndicies[index] << (index * COLUMNS_SNAPSHOT_SYMBOL_BITS);
+		if (index < nextSymbolIndicies.Num()) Trinities |= (uint32)nextSymbolIndicies[index] << ((PAWN_SIZE + index) * COLUMNS_SNAPSHOT_SYMBOL_BITS);
+	}
+}
+
+void FColumnsSnapshot::UnpackBoard(FColumnsBoard& board) const
+{
+	board.Init(NumberOfColumns, NumberOfRows, NumberOfSymbols);
+	board.Unpack(Cells, BitsPerCell, FirstRow);
+}
+
+void FColumnsSnapshotRing::Init(int32 capacity)
+{
+	Slots.SetNum(FMath::Max(capacity, 1));
+	Reset();
+}
+
+FColumnsSnapshot& FColumnsSnapshotRing::Push()
+{
+	Newest = (Newest + 1) % Slots.Num();
+	Count = FMath::Min(Count + 1, Slots.Num());
+
+	return Slots[Newest];
+}
+
+const FColumnsSnapshot* FColumnsSnapshotRing::Rewind(int32 steps)
+{
+	if (steps < 0 || steps >= Count) return nullptr;
+
+	// the dropped slots are written over by the next pushes
+	Newest = (Newest - steps + Slots.Num()) % Slots.Num();
+	Count -= steps;
+
+	return &Slots[Newest];
+}
+
+void FColumnsSnapshotRing::Reset()
+{
+	Count = 0;
+	Newest = INDEX_NONE;
+}
+
+bool FColumnsSaveFile::Load(const FString& filename, int32& outSeed, FColumnsGameSettings& outSettings, FColumnsSnapshot& outSnapshot)
+{
+	const int64 fileSize = sizeof(FColumnsSaveHeader) + sizeof(FColumnsGameSettings) + sizeof(FColumnsSnapshot);
+
+	// map the file rather than reading it; fall back to reading it on platforms that can't map files
+	TArray<uint8> bytes;
+	const uint8* data = nullptr;
+
+	TUniquePtr<IMappedFileHandle> mappedFile(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*filename));
+	TUniquePtr<IMappedFileRegion> mappedRegion;
+	if (mappedFile.IsValid() && mappedFile->GetFileSize() == fileSize)
+	{
+		mappedRegion.Reset(mappedFile->MapRegion(0, fileSize));
+		if (mappedRegion.IsValid()) data = mappedRegion->GetMappedPtr();
+	}
+	else if (!mappedFile.IsValid() && FFileHelper::LoadFileToArray(bytes, *filename, FILEREAD_Silent) && bytes.Num() == fileSize)
+	{
+		data = bytes.GetData();
+	}
+
+	if (data == nullptr) return false;
+
+	FColumnsSaveHeader header;
+	FMemory::Memcpy(&header, data, sizeof(header));
+
+	const FColumnsSaveHeader expected;
+	if (header.Magic != expected.Magic || header.Version != expected.Version
+		|| header.SettingsSize != expected.SettingsSize || header.SnapshotSize != expected.SnapshotSize) return false;
+
+	outSeed = header.Seed;
+	FMemory::Memcpy(&outSettings, data + sizeof(header), sizeof(outSettings));
+	FMemory::Memcpy(&outSnapshot, data + sizeof(header) + sizeof(outSettings), sizeof(outSnapshot));
+
+	return outSnapshot.MatchesSettings(outSettings) && FColumnsSnapshot::GetBitsPerCell(outSnapshot.NumberOfSymbols) == outSnapshot.BitsPerCell;
+}
+
+bool FColumnsSaveFile::Save(const FString& filename, int32 seed, const FColumnsGameSettings& settings, const FColumnsSnapshot& snapshot)
+{
+	FColumnsSaveHeader header;
+	header.Seed = seed;
+
+	TArray<uint8> bytes;
+	bytes.SetNumUninitialized(sizeof(header) + sizeof(settings) + sizeof(snapshot));
+	FMemory::Memcpy(bytes.GetData(), &header, sizeof(header));
+	FMemory::Memcpy(bytes.GetData() + sizeof(header), &settings, sizeof(settings));
+	FMemory::Memcpy(bytes.GetData() + sizeof(header) + sizeof(settings), &snapshot, sizeof(snapshot));
+
+	// written beside the save and moved over it, so a crash part way through leaves the last save whole
+	const FString tempFilename = filename + TEXT(".tmp");
+	return FFileHelper::SaveArrayToFile(bytes, *tempFilename) && IFileManager::Get().Move(*filename, *tempFilename, true);
+}
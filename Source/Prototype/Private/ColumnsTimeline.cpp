@@ -0,0 +1,37 @@
+// Copyright 2019
+#include "ColumnsTimeline.h"
+
+void FColumnsTimeline::AddTrack(int32 cell, const FVector& from, const FVector& to, float durationSeconds, float startSeconds)
+{
+	FColumnsTimelineTrack& track = Tracks.AddDefaulted_GetRef();
+	track.Cell = cell;
+	track.From = from;
+	track.To = to;
+	track.StartSeconds = startSeconds;
+	track.DurationSeconds = FMath::Max(0.0f, durationSeconds);
+
+	DurationSeconds = FMath::Max(DurationSeconds, track.StartSeconds + track.DurationSeconds);
+}
+
+bool FColumnsTimeline::Advance(float deltaSeconds)
+{
+	Seconds += deltaSeconds;
+
+	return IsFinished();
+}
+
+FVector FColumnsTimeline::GetLocation(int32 index) const
+{
+	const FColumnsTimelineTrack& track = Tracks[index];
+	if (track.DurationSeconds <= 0.0f) return Seconds >= track.StartSeconds ? track.To : track.From;
+
+	const float alpha = FMath::Clamp((Seconds - track.StartSeconds) / track.DurationSeconds, 0.0f, 1.0f);
+	return FMath::Lerp(track.From, track.To, alpha);
+}
+
+void FColumnsTimeline::Reset()
+{
+	Tracks.Reset();
+	DurationSeconds = 0.0f;
+	Seconds = 0.0f;
+}
@@ -0,0 +1,42 @@
+// Copyright 2019
+#include "ColumnsTranspositionTable.h"
+
+FColumnsTranspositionTable::FColumnsTranspositionTable(int32 sizeLog2)
+{
+	const uint64 numberOfEntries = 1ull << FMath::Clamp(sizeLog2, 1, 30);
+
+	Entries = MakeUnique<FEntry[]>(numberOfEntries);
+	Mask = numberOfEntries - 1;
+	Clear();
+}
+
+void FColumnsTranspositionTable::Clear()
+{
+	for (uint64 index = 0; index <= Mask; index++)
+	{
+		Entries[index].KeyXorData.Store(0, EMemoryOrder::Relaxed);
+		Entries[index].Data.Store(0, EMemoryOrder::Relaxed);
+	}
+}
+
+bool FColumnsTranspositionTable::Probe(uint64 key, int32 depth, int32& outValue) const
+{
+	const FEntry& entry = Entries[key & Mask];
+	const uint64 data = entry.Data.Load(EMemoryOrder::Relaxed);
+	const uint64 keyXorData = entry.KeyXorData.Load(EMemoryOrder::Relaxed);
+
+	// data is the value in the low 32 bits and the depth above it; a depth of 0 is an empty slot
+	if ((keyXorData ^ data) != key || (int32)(data >> 32) != depth) return false;
+
+	outValue = (int32)(uint32)data;
+	return true;
+}
+
+void FColumnsTranspositionTable::Store(uint64 key, int32 depth, int32 value)
+{
+	FEntry& entry = Entries[key & Mask];
+	const uint64 data = ((uint64)(uint32)depth << 32) | (uint32)value;
+
+	entry.KeyXorData.Store(key ^ data, EMemoryOrder::Relaxed);
+	entry.Data.Store(data, EMemoryOrder::Relaxed);
+}
@@ -2,9 +2,19 @@
 #include "GameBoardActor.h"
 
 #include "Classes/Materials/Material.h"
+#include "EngineUtils.h"
+#include "GridActor.h"
+#include "Prototype.h"
 #include "PrototypePawn.h"
 #include "PrototypeGameModeBase.h"
-#include "Components/StaticMeshComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Mesh Component Rebuild"), STAT_ColumnsMeshRebuild, STATGROUP_Columns);
+DECLARE_CYCLE_STAT(TEXT("Board Tick Animation"), STAT_ColumnsBoardTick, STATGROUP_Columns);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cascade Depth Last Move"), STAT_ColumnsCascadeDepth, STATGROUP_Columns);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Symbols Removed Last Step"), STAT_ColumnsSymbolsRemoved, STATGROUP_Columns);
+
+COLUMNS_TRACE_DECLARE_INT_COUNTER(ColumnsCascadeDepth, TEXT("Columns/Cascade Depth"));
+COLUMNS_TRACE_DECLARE_INT_COUNTER(ColumnsSymbolsRemoved, TEXT("Columns/Symbols Removed"));
 
 AGameBoardActor::AGameBoardActor()
 {
@@ -15,16 +25,19 @@ AGameBoardActor::AGameBoardActor()
 
 void AGameBoardActor::AnimateCollapse()
 {
-	// clear any symbols static mesh components that were highlighted to be removed
-	for (auto index = 0; index < SymbolsToRemove.Num(); index++)
+	// clear any symbols that were highlighted to be removed
+	SymbolRemovingInstancesClear();
+
+	// one track per falling symbol, all falling at the pawn speed
+	const FColumnsCascade& cascade = Game->GetLastCascade();
+	const FColumnsCascadeStep& step = cascade.GetStep(CascadeStep);
+	Timeline.Reset();
+	for (auto index = step.FirstFall; index < step.FirstFall + step.NumberOfFalls; index++)
 	{
-		// find the static mesh component
-		const int32 whichComponent = SymbolsToRemove[index].Row * GAME_BOARD_NUMBER_OF_COLUMNS + SymbolsToRemove[index].Column;
-		if (whichComponent >= 0 && whichComponent < SymbolStaticMeshComponents.Num())
-		{
-			// clear the static mesh so it's invisible
-			SymbolStaticMeshComponents[whichComponent]->SetStaticMesh(nullptr);
-		}
+		const FSymbolFall& fall = cascade.GetFall(index);
+		const float durationSeconds = (fall.ToRow - fall.FromRow) * Spacing / PAWN_SPEED_PIXELS_PER_SECOND;
+		Timeline.AddTrack(fall.FromRow * NumberOfColumns + fall.Column, SymbolInstanceTransform(fall.FromRow, fall.Column).GetLocation(),
+			SymbolInstanceTransform(fall.ToRow, fall.Column).GetLocation(), durationSeconds);
 	}
 	
 	// start up tick for collapse animation
@@ -34,39 +47,38 @@ void AGameBoardActor::AnimateCollapse()
 
 void AGameBoardActor::AnimateRemoveMatches()
 {
-	if (SymbolsToRemove.Num() > 0)
+	const FColumnsCascade& cascade = Game->GetLastCascade();
+	if (CascadeStep >= cascade.GetNumberOfSteps())
+	{
+		FinishCascade();
+		return;
+	}
+
+	const FColumnsCascadeStep& step = cascade.GetStep(CascadeStep);
+	ScoreCascadeStep(step);
+
+	if (step.NumberOfRemoved > 0)
 	{
-		// if any symbols are being removed due to 3 or more adjacent
-		for (auto index = 0; index < SymbolsToRemove.Num(); index++)
+		// if any symbols are being removed due to 3 or more adjacent, move them to the highlighted instances
+		for (auto index = step.FirstRemoved; index < step.FirstRemoved + step.NumberOfRemoved; index++)
 		{
-			// find the static mesh component
-			const int32 whichComponent = SymbolsToRemove[index].Row * GAME_BOARD_NUMBER_OF_COLUMNS + SymbolsToRemove[index].Column;
-			if (whichComponent >= 0 && whichComponent < SymbolStaticMeshComponents.Num())
-			{
-				// set it's material to a highlight material
-				SymbolStaticMeshComponents[whichComponent]->SetMaterial(0, SymbolRemovingMaterial);
-			}
+			const FRowColumn& location = cascade.GetRemoved(index);
+			const int32 cellIndex = location.Row * NumberOfColumns + location.Column;
+			if (cellIndex < 0 || cellIndex >= CellSymbols.Num() || CellSymbols[cellIndex] == INDEX_NONE) continue;
+
+			SymbolRemovingInstanceComponents[CellSymbols[cellIndex]]->AddInstance(SymbolInstanceTransform(location.Row, location.Column));
+			SymbolInstanceRemove(cellIndex);
 		}
 			
 		// start up tick to wait for symbols to hightlight for a short time
+		Timeline.Reset();
 		AnimationState = EAnimationState::SYMBOLS;
 		PrimaryActorTick.SetTickFunctionEnable(true);
 	}
-	else if (SymbolsToCollapse.Num() > 0)
-	{
-		AnimateCollapse();
-	}
 	else
 	{
-		// nothing to animate; reconstruct the component grid
-		SymbolMeshComponentsConstruct();
-		
-		// trigger the pawn to start moving again and accept input
-		APawn* playerPawn = GetWorld()->GetFirstPlayerController()->GetPawn();
-		if (playerPawn != nullptr)
-		{
-			((APrototypePawn*)playerPawn)->TriggerNextMoveEnd();
-		}
+		// a step that removed nothing only collapses
+		AnimateCollapse();
 	}
 }
 
@@ -75,399 +87,256 @@ void AGameBoardActor::BeginPlay()
 	Super::BeginPlay();
 }
 
-TArray<FRowColumn> AGameBoardActor::BoardCollapseEmpty()
-{
-	bool changed = true;
-	TArray<FRowColumn> locationsToMoveDown;
-
-	// find symbols that are above empty spaces and move them down
-	while (changed == true)
-	{
-		changed = false;
-
-		for (auto row = 0; row < (NumberOfRows - 1); row++)
-		{
-			for (auto column = 0; column < NumberOfColumns; column++)
-			{
-				if (BoardGet(row, column) > 0 && BoardGet(row + 1, column) == 0)
-				{
-					BoardSet(row + 1, column, BoardGet(row, column));
-					BoardSet(row, column, 0);
-					changed = true;
-
-					locationsToMoveDown.Add(FRowColumn(row, column));
-				}
-			}
-		}
-	}
-
-	return locationsToMoveDown;
-}
-
 void AGameBoardActor::BoardConstruct()
 {
-	// empty out the board
-	Board.Empty();
-
-	// set up indexing for where to start the random symbols
-	const int32 maxRowToStartSymbols = NumberOfRows - 2;
-	const int32 minRowToStartSymbols = 4;
-
-	// set up default place to start them, in case getting the game mode fails
-	int32 rowToStartRandomSymbols = NumberOfRows - 2;
-
-	APrototypeGameModeBase* gameMode = (APrototypeGameModeBase*)GetWorld()->GetAuthGameMode();
-	if (gameMode != nullptr) rowToStartRandomSymbols = NumberOfRows - (gameMode->GetLevel() + 1);
-
-	if (rowToStartRandomSymbols > maxRowToStartSymbols) rowToStartRandomSymbols = maxRowToStartSymbols;
-	else if (rowToStartRandomSymbols < minRowToStartSymbols) rowToStartRandomSymbols = minRowToStartSymbols;
-
-	// loop over empty portion
-	for (auto row = 0; row < rowToStartRandomSymbols; row++)
-	{
-		for (auto column = 0; column < NumberOfColumns; column++)
-		{
-			Board.Add(0);
-		}
-	}
-
-	// loop over random symbol portion
-	for (auto row = rowToStartRandomSymbols; row < NumberOfRows; row++)
+	// the grid follows the board's size whenever the board is set up
+	if (GridActor == nullptr)
 	{
-		for (auto column = 0; column < NumberOfColumns; column++)
-		{
-			const int32 symbol = (rand() % SymbolStaticMeshArray.Num()) + 1;
-			Board.Add(symbol);
-		}
+		TActorIterator<AGridActor> gridIterator(GetWorld());
+		if (gridIterator) GridActor = *gridIterator;
 	}
+	if (GridActor != nullptr) GridActor->SetDimensions(NumberOfColumns, NumberOfRows);
 
-	// now check for random symbols that are at least 3 adjacent, this is a
-	// problem as the random symbols shouldn't auto-solve the puzzle
-	for (auto row = rowToStartRandomSymbols; row < NumberOfRows; row++)
+	// the game mode owns the game, with its seeded random numbers and replay
+	APrototypeGameModeBase* gameMode = (APrototypeGameModeBase*)GetWorld()->GetAuthGameMode();
+	if (gameMode != nullptr)
 	{
-		for (auto column = 0; column < NumberOfColumns; column++)
-		{
-			if (BoardCheckForAdjacentThree(row, column) != EDirections::INDETERMINATE)
-			{
-				// there are 3 adjacent; try replacing with a count down
-				// this will result in a space if necessary
-				for (int32 trySymbol = SymbolStaticMeshArray.Num(); trySymbol >= 0; trySymbol--)
-				{
-					BoardSet(row, column, trySymbol);
-					if (BoardCheckForAdjacentThree(row, column) == EDirections::INDETERMINATE) break;
-				}
-			}
-		}
+		Game = &gameMode->GetGame();
+		gameMode->StartGame(NumberOfColumns, NumberOfRows, SymbolStaticMeshArray.Num());
 	}
 }
 
-EDirections AGameBoardActor::BoardCheckForAdjacentThree(int32 row, int32 column)
+void AGameBoardActor::BoardSetTrinity(const TArray<int32>& symbolsArray, int32 rowStart, int32 column)
 {
-	const int32 index = row * NumberOfColumns + column;
-
-	// check that the index to check from exists
-	if (index >= Board.Num())
+	// symbols are indexed 0 to number of unique symbols - 1, as the meshes are
+	for (auto index = 0; index < symbolsArray.Num(); index++)
 	{
-		return EDirections::INDETERMINATE;
+		SymbolMeshComponentsSet(index + rowStart, column, symbolsArray[index]);
 	}
+}
 
-	// get the symbol to match against
-	const int32 matchSymbol = Board[index];
+void AGameBoardActor::FastForwardCascade()
+{
+	SymbolRemovingInstancesClear();
 
-	// check left
-	if (column > 1)
+	// every step's removals and falls go straight to the instances, still a step at a time so each fall
+	// finds the cells it left the step before
+	const FColumnsCascade& cascade = Game->GetLastCascade();
+	for (; CascadeStep < cascade.GetNumberOfSteps(); CascadeStep++)
 	{
-		if (BoardGet(row, column - 1) == matchSymbol
-			&& BoardGet(row, column - 2) == matchSymbol)
-			return EDirections::LEFT;
-	}
+		const FColumnsCascadeStep& step = cascade.GetStep(CascadeStep);
+		ScoreCascadeStep(step);
 
-	// check down left
-	if (column > 1 && row < (NumberOfRows - 2))
-	{
-		if (BoardGet(row + 1, column - 1) == matchSymbol
-			&& BoardGet(row + 2, column - 2) == matchSymbol)
-			return EDirections::DOWN_LEFT;
-	}
+		for (auto index = step.FirstRemoved; index < step.FirstRemoved + step.NumberOfRemoved; index++)
+		{
+			const FRowColumn& location = cascade.GetRemoved(index);
+			SymbolInstanceRemove(location.Row * NumberOfColumns + location.Column);
+		}
 
-	// check down
-	if (row < (NumberOfRows - 2))
-	{
-		if (BoardGet(row + 1, column) == matchSymbol
-			&& BoardGet(row + 2, column) == matchSymbol)
-			return EDirections::DOWN;
+		SymbolInstancesFall(step, true);
 	}
 
-	// check down right
-	if (row < (NumberOfRows - 2) && column < (NumberOfColumns - 2))
-	{
-		if (BoardGet(row + 1, column + 1) == matchSymbol
-			&& BoardGet(row + 2, column + 2) == matchSymbol)
-			return EDirections::DOWN_RIGHT;
-	}
+	Timeline.Reset();
+	AnimationState = EAnimationState::IDLE;
+	PrimaryActorTick.SetTickFunctionEnable(false);
+	FinishCascade();
+}
 
-	// check right
-	if (column < (NumberOfColumns - 2))
-	{
-		if (BoardGet(row, column + 1) == matchSymbol
-			&& BoardGet(row, column + 2) == matchSymbol)
-			return EDirections::RIGHT;
-	}
+void AGameBoardActor::FinishCascade()
+{
+	const int32 depth = Game->GetLastCascade().GetDepth();
+	SET_DWORD_STAT(STAT_ColumnsCascadeDepth, depth);
+	COLUMNS_TRACE_COUNTER_SET(ColumnsCascadeDepth, depth);
 
-	// check up right
-	if (row > 1 && column < (NumberOfColumns - 2))
+	// the instances have been kept up to date along the way, unless the game has already scrolled an endless
+	// board or filled the next level's; only the rows in the window have instances
+	if (Game->HasBoardMovedOn())
 	{
-		if (BoardGet(row - 1, column + 1) == matchSymbol
-			&& BoardGet(row - 2, column + 2) == matchSymbol)
-			return EDirections::UP_RIGHT;
+		SymbolMeshComponentsConstruct();
 	}
-
-	// check up
-	if (row > 1)
+	else if (!ensureMsgf(SymbolInstancesMatchBoard(), TEXT("Game board symbol instances don't match the board.")))
 	{
-		if (BoardGet(row - 1, column) == matchSymbol
-			&& BoardGet(row - 2, column) == matchSymbol)
-			return EDirections::UP;
+		SymbolMeshComponentsConstruct();
 	}
-
-	// check up left
-	if (row > 1 && column > 1)
+	
+	// trigger the pawn to start moving again and accept input
+	APawn* playerPawn = GetWorld()->GetFirstPlayerController()->GetPawn();
+	if (playerPawn != nullptr)
 	{
-		if (BoardGet(row - 1, column - 1) == matchSymbol
-			&& BoardGet(row - 2, column - 2) == matchSymbol)
-			return EDirections::UP_LEFT;
+		((APrototypePawn*)playerPawn)->TriggerNextMoveEnd();
 	}
-
-	return EDirections::INDETERMINATE;
 }
 
-int32 AGameBoardActor::BoardGet(const int32 row, const int32 column) const
+void AGameBoardActor::ScoreCascadeStep(const FColumnsCascadeStep& step)
 {
-	const int32 index = row * NumberOfColumns + column;
+	if (step.NumberOfRemoved > 0) SET_DWORD_STAT(STAT_ColumnsSymbolsRemoved, step.NumberOfRemoved);
+	COLUMNS_TRACE_COUNTER_SET(ColumnsSymbolsRemoved, step.NumberOfRemoved);
 
-	if (index >= 0 && index < Board.Num())
-	{
-		return Board[index];
-	}
-
-	// return no symbol if off the edge of the board
-	return 0;
+	APrototypeGameModeBase* gameMode = (APrototypeGameModeBase*)GetWorld()->GetAuthGameMode();
+	if (gameMode != nullptr) gameMode->AddToJewelsAndScore(step.NumberOfRemoved);
 }
 
-TArray<FRowColumn> AGameBoardActor::BoardRemoveMatches()
+void AGameBoardActor::ShowBoard()
 {
-	bool anyMatches = false;
-
-	TArray<FRowColumn> locationsToRemove;
-
-	// loop over all symbols
-	for (auto row = 0; row < NumberOfRows; row++)
-	{
-		for (auto column = 0; column < NumberOfColumns; column++)
-		{
-			// check the symbol at the current location; if empty, skip
-			const int32 matchSymbol = BoardGet(row, column);
-			if (matchSymbol == 0) continue;
-
-			// get horizontal range of matches
-			int32 horizStart = column;
-			while (horizStart > 0 && BoardGet(row, horizStart - 1) == matchSymbol) horizStart--;
-
-			int32 horizEnd = column;
-			while (horizEnd < (NumberOfColumns - 1) && BoardGet(row, horizEnd + 1) == matchSymbol) horizEnd++;
-
-			const int32 horizRangeCount = horizEnd - horizStart + 1;
+	Timeline.Reset();
+	AnimationState = EAnimationState::IDLE;
+	PrimaryActorTick.SetTickFunctionEnable(false);
+	SymbolMeshComponentsConstruct();
+}
 
-			// get vertical range of matches
-			int32 vertStart = row;
-			while (vertStart > 0 && BoardGet(vertStart - 1, column) == matchSymbol) vertStart--;
+void AGameBoardActor::SymbolInstanceAdd(int32 cellIndex, int32 staticMeshIndex)
+{
+	SymbolInstanceRemove(cellIndex);
 
-			int32 vertEnd = row;
-			while (vertEnd < (NumberOfRows - 1) && BoardGet(vertEnd + 1, column) == matchSymbol) vertEnd++;
+	const int32 instance = SymbolInstanceComponents[staticMeshIndex]->AddInstance(SymbolInstanceTransform(cellIndex / NumberOfColumns, cellIndex % NumberOfColumns));
+	check(instance == InstanceCells[staticMeshIndex].Num());
 
-			const int32 vertRangeCount = vertEnd - vertStart + 1;
+	InstanceCells[staticMeshIndex].Add(cellIndex);
+	CellSymbols[cellIndex] = staticMeshIndex;
+	CellInstances[cellIndex] = instance;
+}
 
-			// get angled up right matches
-			int32 upRight[2] = { row, column };
-			while (upRight[0] > 0 && upRight[1] < (NumberOfColumns - 1) && BoardGet(upRight[0] - 1, upRight[1] + 1) == matchSymbol)
-			{
-				upRight[0]--;
-				upRight[1]++;
-			}
+void AGameBoardActor::SymbolInstanceMove(int32 staticMeshIndex, int32 instance, const FTransform& transform)
+{
+	SymbolInstanceComponents[staticMeshIndex]->UpdateInstanceTransform(instance, transform, false, false, true);
+	SymbolInstanceComponentsMoved[staticMeshIndex] = true;
+}
 
-			int32 downLeft[2] = { row, column };
-			while (downLeft[0] < (NumberOfRows - 1) && downLeft[1] > 0 && BoardGet(downLeft[0] + 1, downLeft[1] - 1) == matchSymbol)
-			{
-				downLeft[0]++;
-				downLeft[1]--;
-			}
+void AGameBoardActor::SymbolInstanceRemove(int32 cellIndex)
+{
+	const int32 staticMeshIndex = CellSymbols[cellIndex];
+	if (staticMeshIndex == INDEX_NONE) return;
 
-			const int32 angledUpCount = upRight[1] - downLeft[1] + 1;
+	UInstancedStaticMeshComponent* component = SymbolInstanceComponents[staticMeshIndex];
+	TArray<int32>& cells = InstanceCells[staticMeshIndex];
+	const int32 instance = CellInstances[cellIndex];
+	const int32 lastInstance = cells.Num() - 1;
 
-			// get angled down right matches
-			int32 downRight[2] = { row, column };
-			while (downRight[0] < (NumberOfRows - 1) && downRight[1] < (NumberOfColumns - 1)
-				&& BoardGet(downRight[0] + 1, downRight[1] + 1) == matchSymbol)
-			{
-				downRight[0]++;
-				downRight[1]++;
-			}
+	// removing from the middle would shift every later instance down, so fill the gap with the last one
+	if (instance != lastInstance)
+	{
+		FTransform lastTransform;
+		component->GetInstanceTransform(lastInstance, lastTransform);
+		component->UpdateInstanceTransform(instance, lastTransform, false, false, true);
 
-			int32 upLeft[2] = { row, column };
-			while (upLeft[0] > 0 && upLeft[1] > 0 && BoardGet(upLeft[0] - 1, upLeft[1] - 1) == matchSymbol)
-			{
-				upLeft[0]--;
-				upLeft[1]--;
-			}
+		cells[instance] = cells[lastInstance];
+		CellInstances[cells[instance]] = instance;
+	}
 
-			const int32 angledDownCount = downRight[1] - upLeft[1] + 1;
+	component->RemoveInstance(lastInstance);
+	cells.RemoveAt(lastInstance);
 
-			// if any direction matched 3 or more, proceed to mark for removal
-			if (horizRangeCount > 2 || vertRangeCount > 2 || angledUpCount > 2 || angledDownCount > 2)
-			{
-				anyMatches = true;
-
-				// make an array of the objects to remove, starting with center
-				locationsToRemove.Add(FRowColumn(row, column));
-
-				if (horizRangeCount > 2)
-				{
-					for (auto cspan = horizStart; cspan <= horizEnd; cspan++) {
-						// make sure to skip the center, it was added first
-						if (cspan == column) continue;
-						
-						locationsToRemove.Add(FRowColumn(row, cspan));
-					}
-				}
-
-				if (vertRangeCount > 2)
-				{
-					for (auto rspan = vertStart; rspan <= vertEnd; rspan++)
-					{
-						if (rspan == row) continue;
-						
-						locationsToRemove.Add(FRowColumn(rspan, column));
-					}
-				}
-
-				if (angledUpCount > 2)
-				{
-					int32 rspan = downLeft[0];
-					for (auto cspan = downLeft[1]; cspan <= upRight[1]; cspan++)
-					{
-						if (rspan == row && cspan == column) {
-							rspan--;
-							continue;
-						}
-						
-						locationsToRemove.Add(FRowColumn(rspan, cspan));
-						rspan--;
-					}
-				}
-
-				if (angledDownCount > 2)
-				{
-					int32 rspan = upLeft[0];
-					for (auto cspan = upLeft[1]; cspan <= downRight[1]; cspan++)
-					{
-						if (rspan == row && cspan == column) {
-							rspan++;
-							continue;
-						}
-						
-						locationsToRemove.Add(FRowColumn(rspan, cspan));
-						rspan++;
-					}
-				}
-			}
-		}
-	}
+	CellSymbols[cellIndex] = INDEX_NONE;
+	CellInstances[cellIndex] = INDEX_NONE;
+}
 
-	// remove any duplicates
-	for (auto compareIndex = 0; compareIndex < locationsToRemove.Num() - 1; compareIndex++)
+void AGameBoardActor::SymbolInstancesFall(const FColumnsCascadeStep& step, bool bMoveInstances)
+{
+	// each column's falls go from the bottom up, so every symbol lands in a cell the one below has already left
+	for (auto index = step.FirstFall; index < step.FirstFall + step.NumberOfFalls; index++)
 	{
-		for (auto index = compareIndex + 1; index < locationsToRemove.Num(); index++)
-		{
-			if (locationsToRemove[compareIndex] == locationsToRemove[index])
-			{
-				locationsToRemove.RemoveAt(index);
-				index--;
-			}
-		}
+		const FSymbolFall& fall = Game->GetLastCascade().GetFall(index);
+		const int32 fromIndex = fall.FromRow * NumberOfColumns + fall.Column;
+		const int32 toIndex = fall.ToRow * NumberOfColumns + fall.Column;
+		const int32 staticMeshIndex = CellSymbols[fromIndex];
+		const int32 instance = CellInstances[fromIndex];
+
+		CellSymbols[fromIndex] = INDEX_NONE;
+		CellInstances[fromIndex] = INDEX_NONE;
+		CellSymbols[toIndex] = staticMeshIndex;
+		CellInstances[toIndex] = instance;
+		if (staticMeshIndex == INDEX_NONE) continue;
+
+		InstanceCells[staticMeshIndex][instance] = toIndex;
+		if (bMoveInstances) SymbolInstanceMove(staticMeshIndex, instance, SymbolInstanceTransform(fall.ToRow, fall.Column));
 	}
 
-	// remove symbols
-	for (auto index = 0; index < locationsToRemove.Num(); index++)
+	if (bMoveInstances) SymbolInstancesMarkMovedDirty();
+}
+
+void AGameBoardActor::SymbolInstancesMarkMovedDirty()
+{
+	// a component with no moved instance keeps the instance buffer the renderer already has
+	for (auto index = 0; index < SymbolInstanceComponents.Num(); index++)
 	{
-		BoardSet(locationsToRemove[index].Row, locationsToRemove[index].Column, 0);
-	}
+		if (!SymbolInstanceComponentsMoved[index]) continue;
 
-	return locationsToRemove;
+		SymbolInstanceComponents[index]->MarkRenderStateDirty();
+		SymbolInstanceComponentsMoved[index] = false;
+	}
 }
 
-void AGameBoardActor::BoardSet(int32 row, int32 column, int32 symbol)
+bool AGameBoardActor::SymbolInstancesMatchBoard() const
 {
-	const int32 index = row * NumberOfColumns + column;
+	if (Game == nullptr) return CellSymbols.Num() == 0;
 
-	if (index >= 0 && index < Board.Num() && symbol <= SymbolStaticMeshArray.Num())
+	const FColumnsBoard& board = Game->GetBoard();
+	for (auto index = 0; index < CellSymbols.Num(); index++)
 	{
-		Board[index] = symbol;
+		const int32 symbol = board.Get(index / NumberOfColumns, index % NumberOfColumns);
+		if (CellSymbols[index] != (symbol > 0 ? symbol - 1 : INDEX_NONE)) return false;
 	}
+
+	return true;
 }
 
-void AGameBoardActor::BoardSetTrinity(TArray<int32> symbolsArray, int32 rowStart, int32 column)
+FTransform AGameBoardActor::SymbolInstanceTransform(int32 row, int32 column) const
 {
-	// add symbols to the game board; note symbols to add will be
-	// indexed 0 to number of unique symbols - 1; need to add one
-	// also replace the mesh of the components
-	for (auto index = 0; index < symbolsArray.Num(); index++)
-	{
-		BoardSet(index + rowStart, column, symbolsArray[index] + 1);
-		SymbolMeshComponentsSet(index + rowStart, column, symbolsArray[index]);
-	}
+	return FTransform(FVector(column * Spacing, row * Spacing, 0.0f));
 }
 
 void AGameBoardActor::SymbolMeshComponentsConstruct()
 {
-	// delete old symbols static mesh components first
-	for (auto meshComponent = SymbolStaticMeshComponents.CreateIterator(); meshComponent; meshComponent++)
+	SCOPE_CYCLE_COUNTER(STAT_ColumnsMeshRebuild);
+	TRACE_CPUPROFILER_EVENT_SCOPE(ColumnsMeshRebuild);
+
+	// one component per symbol mesh, and one more with the removing material; only made once
+	if (SymbolInstanceComponents.Num() != SymbolStaticMeshArray.Num())
 	{
-		if (*meshComponent != nullptr) (*meshComponent)->DestroyComponent();
+		for (auto index = 0; index < SymbolStaticMeshArray.Num(); index++)
+		{
+			UInstancedStaticMeshComponent* newComponent = NewObject<UInstancedStaticMeshComponent>(this, FName(*FString::Printf(TEXT("SymbolInstances%d"), index)));
+			newComponent->SetStaticMesh(SymbolStaticMeshArray[index]);
+			newComponent->RegisterComponent();
+			newComponent->AttachToComponent(GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+			SymbolInstanceComponents.Add(newComponent);
+
+			UInstancedStaticMeshComponent* removingComponent = NewObject<UInstancedStaticMeshComponent>(this, FName(*FString::Printf(TEXT("SymbolRemovingInstances%d"), index)));
+			removingComponent->SetStaticMesh(SymbolStaticMeshArray[index]);
+			removingComponent->SetMaterial(0, SymbolRemovingMaterial);
+			removingComponent->RegisterComponent();
+			removingComponent->AttachToComponent(GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+			SymbolRemovingInstanceComponents.Add(removingComponent);
+		}
+	}
+
+	// clear the instances, then add one for every symbol on the board
+	for (auto index = 0; index < SymbolInstanceComponents.Num(); index++)
+	{
+		SymbolInstanceComponents[index]->ClearInstances();
+		SymbolRemovingInstanceComponents[index]->ClearInstances();
 	}
-	SymbolStaticMeshComponents.Empty();
 
-	// register all to remove old ones
-	RegisterAllComponents();
+	InstanceCells.Reset();
+	InstanceCells.SetNum(SymbolStaticMeshArray.Num());
+	SymbolInstanceComponentsMoved.Init(false, SymbolStaticMeshArray.Num());
+	CellSymbols.Init(INDEX_NONE, NumberOfColumns * NumberOfRows);
+	CellInstances.Init(INDEX_NONE, NumberOfColumns * NumberOfRows);
 
-	// loop over the game board making the components
-	int32 symbol = 1;
+	// an animation moves each cell's symbol at most once
+	Timeline.Reserve(NumberOfColumns * NumberOfRows);
+	if (Game == nullptr) return;
+
+	const FColumnsBoard& board = Game->GetBoard();
 	for (auto row = 0; row < NumberOfRows; row++)
 	{
 		for (auto column = 0; column < NumberOfColumns; column++)
 		{
-			const FName uniqueName = FName(*FString::Printf(TEXT("Symbol%d"), symbol));
-			UStaticMeshComponent* newComponent = NewObject<UStaticMeshComponent>(this, uniqueName);
-
-			if (newComponent != nullptr)
+			const int32 symbolIndex = board.Get(row, column) - 1;
+			if (symbolIndex >= 0 && symbolIndex < SymbolStaticMeshArray.Num())
 			{
-				SymbolStaticMeshComponents.Add(newComponent);
-				newComponent->RegisterComponent();
-				newComponent->SetRelativeLocation(FVector(column * Spacing, row * Spacing, 0.0f));
-				newComponent->AttachToComponent(GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
-
-				const int32 boardIndex = row * NumberOfColumns + column;
-				if (boardIndex >= 0 && boardIndex < Board.Num())
-				{
-					const int32 symbolIndex = Board[boardIndex] - 1;
-
-					if (symbolIndex >= 0 && symbolIndex < SymbolStaticMeshArray.Num())
-					{
-						newComponent->SetStaticMesh(SymbolStaticMeshArray[symbolIndex]);
-					}
-				}
+				SymbolInstanceAdd(row * NumberOfColumns + column, symbolIndex);
 			}
-
-			symbol++;
 		}
 	}
 }
@@ -476,81 +345,87 @@ void AGameBoardActor::SymbolMeshComponentsSet(int32 row, int32 column, int32 sta
 {
 	const int32 index = row * NumberOfColumns + column;
 
-	if (index >= 0 && index < SymbolStaticMeshComponents.Num() 
+	if (index >= 0 && index < CellSymbols.Num() 
 		&& staticMeshIndex >= 0 && staticMeshIndex < SymbolStaticMeshArray.Num())
 	{
-		SymbolStaticMeshComponents[index]->SetStaticMesh(SymbolStaticMeshArray[staticMeshIndex]);
+		SymbolInstanceAdd(index, staticMeshIndex);
+	}
+}
+
+void AGameBoardActor::SymbolRemovingInstancesClear()
+{
+	for (auto index = 0; index < SymbolRemovingInstanceComponents.Num(); index++)
+	{
+		if (SymbolRemovingInstanceComponents[index]->GetInstanceCount() > 0) SymbolRemovingInstanceComponents[index]->ClearInstances();
 	}
 }
 
 void AGameBoardActor::TriggerRemoveCollapseAnimate()
 {
-	// continue the symbol removal/collapse empty process
 	APrototypeGameModeBase* gameMode = (APrototypeGameModeBase*)GetWorld()->GetAuthGameMode();
 
-	if (gameMode != nullptr)
+	if (gameMode != nullptr && Game != nullptr)
 	{
-		// collapse all matched symbols
-		SymbolsToRemove = BoardRemoveMatches();
-
-		// collapse all empties below symbols
-		SymbolsToCollapse = BoardCollapseEmpty();
+		// the game settled the board as the trinity landed; the steps that got it there are played back to the instances
+		CascadeStep = 0;
+		AnimationRate = FMath::Max(gameMode->GetCascadeAnimationRate(), CASCADE_MIN_ANIMATION_RATE) * gameMode->GetTurboMultiplier();
 
-		// add to the score
-		gameMode->AddToJewelsAndScore(SymbolsToRemove.Num());
-
-		// trigger the game board to animate symbol removal/empty collapse, if any exist
-		AnimateRemoveMatches();
+		if (gameMode->IsFastForwardingCascades()) FastForwardCascade();
+		else AnimateRemoveMatches();
 	}
 }
 
 void AGameBoardActor::Tick(float DeltaTime)
 {
-	static float symbolTime = 0.0f;
-	
+	SCOPE_CYCLE_COUNTER(STAT_ColumnsBoardTick);
+	TRACE_CPUPROFILER_EVENT_SCOPE(ColumnsBoardTick);
+
 	Super::Tick(DeltaTime);
 
+	const bool bFinished = Timeline.Advance(DeltaTime * AnimationRate);
+
 	switch (AnimationState)
 	{
 	case EAnimationState::SYMBOLS:
-		symbolTime += DeltaTime;
-		if (symbolTime >= SYMBOL_HIGHLIGHT_SECONDS)
+		if (Timeline.GetSeconds() >= SYMBOL_HIGHLIGHT_SECONDS)
 		{
-			symbolTime = 0;
-			if(SymbolsToCollapse.Num() > 0) AnimateCollapse();
+			if (Game->GetLastCascade().GetStep(CascadeStep).NumberOfFalls > 0) AnimateCollapse();
 			else
 			{
+				SymbolRemovingInstancesClear();
 				AnimationState = EAnimationState::IDLE;
 				PrimaryActorTick.SetTickFunctionEnable(false);
-				TriggerRemoveCollapseAnimate();
+				CascadeStep++;
+				AnimateRemoveMatches();
 			}
 		}
 		break;
 	case EAnimationState::EMPTY:
-		for (auto index = 0; index < SymbolsToCollapse.Num(); index++)
+	{
+		// move the instance of every track to where the timeline has it now
+		for (auto index = 0; index < Timeline.GetNumberOfTracks(); index++)
 		{
-			// find the static mesh components to move
-			const int32 whichComponent = SymbolsToCollapse[index].Row * GAME_BOARD_NUMBER_OF_COLUMNS + SymbolsToCollapse[index].Column;
-			if (whichComponent >= 0 && whichComponent < SymbolStaticMeshComponents.Num())
-			{
-				// move them down
-				SymbolStaticMeshComponents[whichComponent]->AddRelativeLocation(FVector(0.0f, DeltaTime * PAWN_SPEED_PIXELS_PER_SECOND, 0.0f));
-				
-				// if they've move one space, stop animation
-				if (SymbolStaticMeshComponents[whichComponent]->GetRelativeTransform().GetLocation().Y >= (SymbolsToCollapse[index].Row + 1) * GAME_BOARD_SPACING)
-				{
-					// regenerate the symbol mesh components to match the board
-					SymbolMeshComponentsConstruct();
-
-					// stop tick, check if there's more symbols matching or more that need to move down
-					AnimationState = EAnimationState::IDLE;
-					PrimaryActorTick.SetTickFunctionEnable(false);
-					TriggerRemoveCollapseAnimate();
-					break;
-				}
-			}
+			const int32 cellIndex = Timeline.GetTrack(index).Cell;
+			if (cellIndex < 0 || cellIndex >= CellSymbols.Num() || CellSymbols[cellIndex] == INDEX_NONE) continue;
+
+			SymbolInstanceMove(CellSymbols[cellIndex], CellInstances[cellIndex], FTransform(Timeline.GetLocation(index)));
+		}
+
+		// send the moved instances to the renderer once per component that has any
+		SymbolInstancesMarkMovedDirty();
+
+		if (bFinished)
+		{
+			// the fallen instances now belong to their destination cells
+			SymbolInstancesFall(Game->GetLastCascade().GetStep(CascadeStep), false);
+
+			// stop tick, and play the next step of the cascade
+			AnimationState = EAnimationState::IDLE;
+			PrimaryActorTick.SetTickFunctionEnable(false);
+			CascadeStep++;
+			AnimateRemoveMatches();
 		}
 		break;
 	}
+	}
 }
-
@@ -1,16 +1,19 @@
 // Copyright 2019
 #include "GridActor.h"
 
-#include "Components/StaticMeshComponent.h"
-#include "GameBoardActor.h"
+#include "ColumnsBoard.h"
 
 AGridActor::AGridActor()
 {
-	// disable tick
-	PrimaryActorTick.bCanEverTick = true;
+	// the grid never changes by itself, so never tick
+	PrimaryActorTick.bCanEverTick = false;
 
 	// get the static mesh from world or blueprint to use as the grid static mesh
 	GridStaticMesh = CreateDefaultSubobject<UStaticMesh>(TEXT("GridStaticMesh"));
+
+	// every grid point is an instance of the one component
+	GridInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("GridInstances"));
+	SetRootComponent(GridInstances);
 }
 
 void AGridActor::BeginPlay()
@@ -22,41 +25,35 @@ void AGridActor::BeginPlay()
 
 void AGridActor::ConstructGrid()
 {
-	// clear out array if it exists
-	for (auto gridComponent = GridMeshComponents.CreateIterator(); gridComponent; gridComponent++)
+	GridInstances->SetStaticMesh(GridStaticMesh);
+
+	// move the instances there are already, then add or remove to make up the difference
+	const int32 numberOfPoints = (NumberOfRows + 1) * (NumberOfColumns + 1);
+	const int32 numberOfInstances = GridInstances->GetInstanceCount();
+
+	for (auto point = 0; point < numberOfPoints; point++)
 	{
-		if((*gridComponent) != nullptr) (*gridComponent)->DestroyComponent();
-	}
-	GridMeshComponents.Empty();
+		const int32 row = point / (NumberOfColumns + 1);
+		const int32 column = point % (NumberOfColumns + 1);
+		const FTransform transform(FVector(column * GAME_BOARD_SPACING, row * GAME_BOARD_SPACING, 0.0f));
 
-	// update component registration to remove them from the world
-	RegisterAllComponents();
+		if (point < numberOfInstances) GridInstances->UpdateInstanceTransform(point, transform, false, false, true);
+		else GridInstances->AddInstance(transform);
+	}
 
-	// loop over grid and generate
-	int32 point = 1;
-	for (auto row = 0; row < GAME_BOARD_NUMBER_OF_ROWS + 1; row++)
+	for (auto point = numberOfInstances - 1; point >= numberOfPoints; point--)
 	{
-		for (auto column = 0; column < GAME_BOARD_NUMBER_OF_COLUMNS + 1; column++)
-		{
-			// create a unique name - all components must have a unique name
-			const FName uniqueName = FName(*FString::Printf(TEXT("GridPoint%d"), point++));
-
-			UStaticMeshComponent* newComponent = NewObject<UStaticMeshComponent>(this, uniqueName);
-			if (newComponent != nullptr)
-			{
-				GridMeshComponents.Add(newComponent);
-				newComponent->SetStaticMesh(GridStaticMesh);
-				newComponent->SetRelativeLocation(FVector(column * GAME_BOARD_SPACING, row * GAME_BOARD_SPACING, 0.0f));
-				if (row == 0 && column == 0) SetRootComponent(newComponent);
-				else newComponent->AttachToComponent(GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
-				newComponent->RegisterComponent();
-			}
-		}
+		GridInstances->RemoveInstance(point);
 	}
+
+	GridInstances->MarkRenderStateDirty();
 }
 
-void AGridActor::Tick(float DeltaTime)
+void AGridActor::SetDimensions(int32 numberOfColumns, int32 numberOfRows)
 {
-	Super::Tick(DeltaTime);
-}
+	if (numberOfColumns == NumberOfColumns && numberOfRows == NumberOfRows) return;
 
+	NumberOfColumns = numberOfColumns;
+	NumberOfRows = numberOfRows;
+	ConstructGrid();
+}
@@ -0,0 +1,42 @@
+// Copyright 2019
+#include "MeshComponentPool.h"
+
+FMeshComponentPool::FMeshComponentPool(const TCHAR* inNamePrefix)
+	: NamePrefix(inNamePrefix)
+{
+}
+
+UStaticMeshComponent* FMeshComponentPool::Acquire(AActor* owner, USceneComponent* parent, UStaticMesh* staticMesh, const FVector& relativeLocation)
+{
+	// only create a component when every one is in use
+	if (NumberInUse == Components.Num())
+	{
+		const FName uniqueName = FName(*FString::Printf(TEXT("%s%d"), *NamePrefix, Components.Num() + 1));
+		UStaticMeshComponent* newComponent = NewObject<UStaticMeshComponent>(owner, uniqueName);
+		if (newComponent == nullptr) return nullptr;
+
+		newComponent->RegisterComponent();
+		Components.Add(newComponent);
+	}
+
+	UStaticMeshComponent* component = Components[NumberInUse++];
+	component->SetStaticMesh(staticMesh);
+	component->AttachToComponent(parent, FAttachmentTransformRules::KeepRelativeTransform);
+	component->SetRelativeLocation(relativeLocation);
+	component->SetVisibility(true);
+
+	return component;
+}
+
+void FMeshComponentPool::HideReleased()
+{
+	for (auto index = NumberInUse; index < Components.Num(); index++)
+	{
+		Components[index]->SetVisibility(false);
+	}
+}
+
+void FMeshComponentPool::ReleaseAll()
+{
+	NumberInUse = 0;
+}
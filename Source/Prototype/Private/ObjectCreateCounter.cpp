@@ -0,0 +1,33 @@
+// Copyright 2019
+#include "ObjectCreateCounter.h"
+
+FObjectCreateCounter::~FObjectCreateCounter()
+{
+	Unregister();
+}
+
+void FObjectCreateCounter::NotifyUObjectCreated(const UObjectBase* Object, int32 Index)
+{
+	Count.Increment();
+}
+
+void FObjectCreateCounter::OnUObjectArrayShutdown()
+{
+	Unregister();
+}
+
+void FObjectCreateCounter::Register()
+{
+	if (bRegistered) return;
+
+	GUObjectArray.AddUObjectCreateListener(this);
+	bRegistered = true;
+}
+
+void FObjectCreateCounter::Unregister()
+{
+	if (!bRegistered) return;
+
+	GUObjectArray.RemoveUObjectCreateListener(this);
+	bRegistered = false;
+}
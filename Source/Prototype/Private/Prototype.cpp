@@ -3,3 +3,5 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Prototype, "Prototype" );
+
+DEFINE_LOG_CATEGORY(LogColumns);
@@ -1,12 +1,347 @@
 // Copyright 2019
 
 #include "PrototypeGameModeBase.h"
+#include "Async/Async.h"
+#include "HAL/PlatformTime.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/Paths.h"
+#include "Prototype.h"
 #include "PrototypeGameInstance.h"
+#include "PrototypePawn.h"
+#include "TimerManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Advance Game"), STAT_ColumnsAdvanceGame, STATGROUP_Columns);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("UObjects Created Last Move"), STAT_ColumnsObjectsCreatedLastMove, STATGROUP_Columns);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("UObjects Created After First Move"), STAT_ColumnsObjectsCreatedAfterFirstMove, STATGROUP_Columns);
+
+// Returns the file the game is written to after every move, to resume from.
+static FString GetCheckpointFilename()
+{
+	return FPaths::ProjectSavedDir() / TEXT("SaveGames") / TEXT("Columns.checkpoint");
+}
 
 void APrototypeGameModeBase::AddToJewelsAndScore(const int32 jewels)
 {
 	Jewels += jewels;
 	
 	// Score takes into account the number of jewels collected in one go
-	Score += jewels * (jewels - 2);
+	Score += FColumnsGame::ScoreForJewels(jewels);
+}
+
+bool APrototypeGameModeBase::AdvanceGame(int32 deltaMs)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ColumnsAdvanceGame);
+	TRACE_CPUPROFILER_EVENT_SCOPE(ColumnsAdvanceGame);
+
+	// a checkpoint that was waiting on the last save goes as soon as that's done
+	SavePendingCheckpoint();
+
+	// the next level's board is handed over as soon as it's filled, so it's there for the landing that finishes the level
+	if (NextBoardFill.IsValid() && NextBoardFill.IsReady())
+	{
+		Game.SetNextBoard(NextBoard.Get());
+		NextBoardFill = TFuture<void>();
+	}
+
+	// a landing resolves its whole cascade in the game; the board plays it back after
+	const int32 piecesPlaced = Game.GetPiecesPlaced();
+	const int32 level = Game.GetLevel();
+	const bool bWasGameOver = Game.IsGameOver();
+	Game.AdvanceMs(deltaMs);
+	if (Game.GetPiecesPlaced() == piecesPlaced && Game.IsGameOver() == bWasGameOver) return false;
+
+	if (bRecordReplays) Replay.RecordLanded(Game.GetLastLandedMs(), Game.GetLastLandedColumn(), Game.GetLastLandedRow());
+	if (Game.GetLevel() != level) PrefetchNextBoard();
+	return true;
+}
+
+void APrototypeGameModeBase::AdvanceLevel()
+{
+	Level++;
+	Jewels = 0;
+
+	UpdateGameInstance();
+}
+
+bool APrototypeGameModeBase::ApplyInput(EColumnsInput input)
+{
+	// an input the trinity couldn't take changes nothing, so the replay leaves it out
+	if (!Game.ApplyInput(input)) return false;
+
+	if (bRecordReplays) Replay.RecordInput(input, Game.GetPieceMs());
+	return true;
+}
+
+void APrototypeGameModeBase::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ObjectCreateCounter.Register();
+
+	Snapshots.Init(RewindMoves);
+
+	// the board and pawn begin play after the game mode
+	if (bResumeCheckpoint) GetWorldTimerManager().SetTimerForNextTick(this, &APrototypeGameModeBase::ResumeCheckpoint);
+}
+
+bool APrototypeGameModeBase::CheckReplay() const
+{
+	FColumnsGame replayed;
+	FString error;
+	if (!Replay.Play(replayed, error))
+	{
+		UE_LOG(LogColumns, Warning, TEXT("The replay doesn't play back the game: %s"), *error);
+		return false;
+	}
+
+	// every landing matched, so the pieces and score should too
+	if (replayed.GetPiecesPlaced() != Game.GetPiecesPlaced() || replayed.GetScore() != Game.GetScore())
+	{
+		UE_LOG(LogColumns, Warning, TEXT("The replay placed %d pieces for a score of %d; the game placed %d for %d."),
+			replayed.GetPiecesPlaced(), replayed.GetScore(), Game.GetPiecesPlaced(), Game.GetScore());
+		return false;
+	}
+
+	UE_LOG(LogColumns, Log, TEXT("The replay plays back the game's %d pieces and score of %d."), Game.GetPiecesPlaced(), Game.GetScore());
+	return true;
+}
+
+void APrototypeGameModeBase::ClearLevelStartedText()
+{
+	// the end of the game shows its own text
+	if (!Game.IsGameOver()) CenteredText = FText::GetEmpty();
+}
+
+void APrototypeGameModeBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	ObjectCreateCounter.Unregister();
+
+	// the game is going, so it's the one place to wait: finish the save being written, then write the newest
+	if (CheckpointSave.IsValid()) CheckpointSave.Wait();
+	SavePendingCheckpoint();
+	if (CheckpointSave.IsValid()) CheckpointSave.Wait();
+
+	if (bRecordReplays && Replay.GetEvents().Num() > 0)
+	{
+		CheckReplay();
+
+		const FString filename = FPaths::ProjectSavedDir() / TEXT("Replays") / FString::Printf(TEXT("Columns-%s.replay"), *FDateTime::Now().ToString());
+		if (!Replay.SaveToFile(filename))
+		{
+			UE_LOG(LogColumns, Warning, TEXT("Failed to save replay %s."), *filename);
+		}
+	}
+}
+
+FColumnsGameSettings APrototypeGameModeBase::GetGameSettings(int32 numberOfColumns, int32 numberOfRows, int32 numberOfSymbols) const
+{
+	FColumnsGameSettings settings;
+	settings.NumberOfColumns = numberOfColumns;
+	settings.NumberOfRows = numberOfRows;
+	settings.NumberOfSymbols = numberOfSymbols;
+	settings.StartLevel = Level;
+	settings.JewelsRequired = JewelsRequired;
+	settings.EndlessRows = EndlessRows;
+
+	return settings;
+}
+
+uint32 APrototypeGameModeBase::GetSearchSeed() const
+{
+	FColumnsRandom random(((uint64)(uint32)Seed << 32) | (uint32)Game.GetPiecesPlaced(), COLUMNS_RANDOM_STREAM_SEARCH);
+	return random.Next();
+}
+
+void APrototypeGameModeBase::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	Seed = UGameplayStatics::GetIntOption(Options, TEXT("Seed"), Seed);
+	EndlessRows = UGameplayStatics::GetIntOption(Options, TEXT("Endless"), EndlessRows);
+	TurboMultiplier = UGameplayStatics::GetIntOption(Options, TEXT("Turbo"), TurboMultiplier);
+	if (UGameplayStatics::HasOption(Options, TEXT("FastForward"))) bFastForwardCascades = true;
+
+	// a resumed game carries on with the seed and rules it was saved with
+	if (UGameplayStatics::HasOption(Options, TEXT("Resume")))
+	{
+		int32 savedSeed = 0;
+		FColumnsGameSettings settings;
+		bResumeCheckpoint = FColumnsSaveFile::Load(GetCheckpointFilename(), savedSeed, settings, ResumeSnapshot);
+		if (bResumeCheckpoint)
+		{
+			Seed = savedSeed;
+			JewelsRequired = settings.JewelsRequired;
+			EndlessRows = settings.EndlessRows;
+		}
+		else
+		{
+			UE_LOG(LogColumns, Warning, TEXT("No checkpoint save to resume in %s."), *GetCheckpointFilename());
+		}
+	}
+
+	if (Seed == 0) Seed = (int32)(FPlatformTime::Cycles() | 1);
+}
+
+void APrototypeGameModeBase::PrefetchNextBoard()
+{
+	// the game lets go of the last board; a fill still running on it keeps it until it's done
+	Game.SetNextBoard(nullptr);
+	NextBoardFill = TFuture<void>();
+
+	NextBoard = MakeShared<FColumnsNextBoard, ESPMode::ThreadSafe>();
+	if (!Game.PrepareNextBoard(*NextBoard))
+	{
+		NextBoard.Reset();
+		return;
+	}
+
+	// filled where it is, and lent to the game from there, so the board is never copied
+	TSharedPtr<FColumnsNextBoard, ESPMode::ThreadSafe> next = NextBoard;
+	NextBoardFill = Async(EAsyncExecution::ThreadPool, [next]()
+	{
+		next->Fill();
+	});
+}
+
+bool APrototypeGameModeBase::RestoreSnapshotState(const FColumnsSnapshot& snapshot)
+{
+	if (!Game.RestoreSnapshot(snapshot)) return false;
+
+	// the board random numbers may have gone back a level
+	PrefetchNextBoard();
+
+	Level = snapshot.Level;
+	Jewels = snapshot.Jewels;
+	Score = ScoreAtStart + snapshot.Score;
+	UpdateGameInstance();
+
+	// the replay picks up again from the snapshot, as if the moves since were never made
+	Replay.RewindEvents(snapshot.ReplayEvents);
+
+	return true;
+}
+
+void APrototypeGameModeBase::ResumeCheckpoint()
+{
+	// checkpoints are written again from here on, whether or not the save could be resumed
+	bResumeCheckpoint = false;
+
+	APrototypePawn* pawn = Cast<APrototypePawn>(UGameplayStatics::GetPlayerPawn(this, 0));
+	if (pawn == nullptr || !RestoreSnapshotState(ResumeSnapshot))
+	{
+		UE_LOG(LogColumns, Warning, TEXT("The checkpoint save doesn't fit the game board; starting a new game."));
+		return;
+	}
+
+	pawn->ShowGame();
+
+	// the new game started before the resume isn't one to step back to
+	Snapshots.Reset();
+	if (RewindMoves > 0) Snapshots.Push() = ResumeSnapshot;
+
+	// the replay would start from the seed, which the resumed game has long moved on from
+	bRecordReplays = false;
+}
+
+bool APrototypeGameModeBase::Rewind(int32 moves)
+{
+	const FColumnsSnapshot* snapshot = Snapshots.Rewind(moves);
+
+	return snapshot != nullptr && RestoreSnapshotState(*snapshot);
+}
+
+void APrototypeGameModeBase::SavePendingCheckpoint()
+{
+	// the game thread never waits on a save; while one is being written, only the newest snapshot is kept
+	if (!bCheckpointPending || (CheckpointSave.IsValid() && !CheckpointSave.IsReady())) return;
+
+	bCheckpointPending = false;
+
+	// written on a worker from copies
+	const FString filename = GetCheckpointFilename();
+	const int32 seed = Seed;
+	const FColumnsGameSettings settings = Game.GetSettings();
+	const FColumnsSnapshot snapshot = PendingCheckpoint;
+	CheckpointSave = Async(EAsyncExecution::ThreadPool, [filename, seed, settings, snapshot]()
+	{
+		if (FColumnsSaveFile::Save(filename, seed, settings, snapshot)) return true;
+
+		UE_LOG(LogColumns, Warning, TEXT("Failed to save checkpoint %s."), *filename);
+		return false;
+	});
+}
+
+void APrototypeGameModeBase::StartGame(int32 numberOfColumns, int32 numberOfRows, int32 numberOfSymbols)
+{
+	const FColumnsGameSettings settings = GetGameSettings(numberOfColumns, numberOfRows, numberOfSymbols);
+	Game.Reset(settings, Seed);
+	Replay.Begin(Seed, settings);
+	PrefetchNextBoard();
+
+	ScoreAtStart = Score;
+	Jewels = 0;
+	bGameStarted = true;
+
+	// the first trinity can be stepped back to like any other; a checkpoint waiting to resume isn't replaced
+	Snapshots.Reset();
+	TakeSnapshot();
+
+	// the pawn shows the first trinity now if it's begun play, and as it begins play otherwise
+	APrototypePawn* pawn = Cast<APrototypePawn>(UGameplayStatics::GetPlayerPawn(this, 0));
+	if (pawn != nullptr && pawn->HasActorBegunPlay()) pawn->ShowGame();
+}
+
+void APrototypeGameModeBase::TakeSnapshot()
+{
+	if (RewindMoves <= 0 && !bSaveCheckpoints) return;
+
+	FColumnsSnapshot snapshot;
+	if (!Game.CaptureSnapshot(snapshot)) return;
+
+	snapshot.ReplayEvents = Replay.GetEvents().Num();
+
+	if (RewindMoves > 0) Snapshots.Push() = snapshot;
+
+	if (bSaveCheckpoints && !bResumeCheckpoint)
+	{
+		PendingCheckpoint = snapshot;
+		bCheckpointPending = true;
+		SavePendingCheckpoint();
+	}
+}
+
+void APrototypeGameModeBase::TriggerLevelStarted_Implementation()
+{
+	CenteredText = FText::Format(NSLOCTEXT("Prototype", "LevelStarted", "Level {0}"), FText::AsNumber(Level));
+	GetWorldTimerManager().SetTimer(CenteredTextTimer, this, &APrototypeGameModeBase::ClearLevelStartedText, LEVEL_STARTED_TEXT_SECONDS);
+}
+
+void APrototypeGameModeBase::UpdateGameInstance()
+{
+	// the game instance carries the level and score over a map reload; keep it current for anything that reads it
+	UPrototypeGameInstance* gameInstance = Cast<UPrototypeGameInstance>(GetGameInstance());
+	if (gameInstance != nullptr)
+	{
+		gameInstance->Level = Level;
+		gameInstance->Score = Score;
+	}
+}
+
+void APrototypeGameModeBase::UpdateMoveStats()
+{
+	const int32 objectCount = ObjectCreateCounter.GetCount();
+
+	// the first move creates the pooled components; every move after should create none
+	if (ObjectCountAtMoveStart != INDEX_NONE)
+	{
+		const int32 created = objectCount - ObjectCountAtMoveStart;
+		SET_DWORD_STAT(STAT_ColumnsObjectsCreatedLastMove, created);
+		INC_DWORD_STAT_BY(STAT_ColumnsObjectsCreatedAfterFirstMove, created);
+
+		if (created > 0) UE_LOG(LogColumns, Verbose, TEXT("%d UObjects created in the last move."), created);
+	}
+
+	ObjectCountAtMoveStart = objectCount;
 }
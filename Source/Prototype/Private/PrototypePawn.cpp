@@ -1,10 +1,19 @@
 // Copyright 2019
 #include "PrototypePawn.h"
 
+#include "Async/Async.h"
 #include "Components/InputComponent.h"
 #include "PrototypeGameModeBase.h"
 #include "Components/StaticMeshComponent.h"
 #include "GameBoardActor.h"
+#include "HAL/PlatformTime.h"
+#include "Materials/MaterialInterface.h"
+#include "Misc/CommandLine.h"
+#include "Prototype.h"
+
+DECLARE_CYCLE_STAT(TEXT("Pawn Tick Movement"), STAT_ColumnsPawnTick, STATGROUP_Columns);
+DECLARE_CYCLE_STAT(TEXT("Land To Next Piece"), STAT_ColumnsLandToNextPiece, STATGROUP_Columns);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pawn Steps Last Frame"), STAT_ColumnsPawnSteps, STATGROUP_Columns);
 
 APrototypePawn::APrototypePawn()
 {
@@ -20,165 +29,163 @@ void APrototypePawn::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// create the first batch of symbols
-	ConstructTrinity();
+	if (FParse::Param(FCommandLine::Get(), TEXT("autoplay"))) bAutoPlay = true;
 
-	// Set up the downward movement speed based on level.
+	// show the first trinity if the board has started the game; otherwise starting it shows the pawn
 	APrototypeGameModeBase *gameMode = (APrototypeGameModeBase *)GetWorld()->GetAuthGameMode();
-	if (gameMode != nullptr)
-	{
-		GravityPixelsPerSecond = PAWN_GRAVITY_PIXELS_PER_SECOND + (gameMode->GetLevel() * PAWN_GRAVITY_LEVEL_SCALE);
-	}
+	if (gameMode != nullptr && gameMode->IsGameStarted()) ShowGame();
 }
 
-void APrototypePawn::ConstructTrinity() 
+void APrototypePawn::ApplyInput(EColumnsInput input)
 {
-	// remove current symbol components
-	for (auto oldComponents = CurrentPawnStaticMeshComponents.CreateIterator(); oldComponents; oldComponents++)
-	{
-		if ((*oldComponents) != nullptr) (*oldComponents)->DestroyComponent();
-	}
-	CurrentPawnStaticMeshComponents.Empty();
-	CurrentSymbolIndicies.Empty();
+	APrototypeGameModeBase* gameMode = (APrototypeGameModeBase*)GetWorld()->GetAuthGameMode();
+	if (gameMode == nullptr || !gameMode->ApplyInput(input)) return;
+
+	// a move is drawn sliding across by the next steps; a shuffle shows at once
+	if (input == EColumnsInput::SHUFFLE_DOWN || input == EColumnsInput::SHUFFLE_UP) ShowTrinitySymbols();
+}
 
-	// remove next symbol components
-	for (auto oldComponents = NextPawnStaticMeshComponents.CreateIterator(); oldComponents; oldComponents++)
+void APrototypePawn::AutoPlayTick()
+{
+	APrototypeGameModeBase* gameMode = (APrototypeGameModeBase*)GetWorld()->GetAuthGameMode();
+	if (gameMode == nullptr) return;
+
+	const FColumnsGame& game = gameMode->GetGame();
+
+	// start the search once per trinity, on a copy of the game so the frame isn't held up
+	if (!AutoPlaySearch.IsValid())
 	{
-		if ((*oldComponents) != nullptr) (*oldComponents)->DestroyComponent();
+		FColumnsSearchSettings searchSettings;
+		searchSettings.MaxDepth = AutoPlayDepth;
+		searchSettings.BudgetSeconds = AutoPlayBudgetSeconds;
+
+		if (!AutoPlayTable.IsValid()) AutoPlayTable = MakeShared<FColumnsTranspositionTable, ESPMode::ThreadSafe>(18);
+
+		const uint32 seed = gameMode->GetSearchSeed();
+		TSharedPtr<FColumnsTranspositionTable, ESPMode::ThreadSafe> table = AutoPlayTable;
+		AutoPlaySearch = Async(EAsyncExecution::ThreadPool, [game, searchSettings, seed, table]()
+		{
+			return FColumnsSearch(searchSettings, table.Get()).Search(game, seed);
+		});
+		return;
 	}
-	NextPawnStaticMeshComponents.Empty();
 
-	// remove them from the actor
-	RegisterAllComponents();
+	if (!bAutoPlayTargetSet)
+	{
+		if (!AutoPlaySearch.IsReady()) return;
 
-	// reset location
-	LocationX = 0;
-	LocationY = -PAWN_SIZE;
-	DesiredLocationX = 0;
-	DesiredLocationY = -PAWN_SIZE;
+		AutoPlayTarget = AutoPlaySearch.Get().Placement;
+		AutoPlayShuffleDownsLeft = AutoPlayTarget.ShuffleDowns;
+		bAutoPlayTargetSet = true;
+	}
 
-	// if the next symbols have already been created, use them
-	if (NextSymbolIndicies.Num() > 0)
+	// one input per step, like a player pressing keys
+	if (AutoPlayShuffleDownsLeft > 0)
 	{
-		CurrentSymbolIndicies = NextSymbolIndicies;
+		ShuffleDown();
+		AutoPlayShuffleDownsLeft--;
 	}
-	else
+	else if (AutoPlayTarget.Column < game.GetLocationX())
 	{
-		// otherwise just randomly generate them
-		for (auto index = 0; index < PAWN_SIZE; index++)
-		{
-			const int32 symbolIndex = rand() % SymbolStaticMeshArray.Num();
-			CurrentSymbolIndicies.Add(symbolIndex);
-		}
+		MoveLeft();
+	}
+	else if (AutoPlayTarget.Column > game.GetLocationX())
+	{
+		MoveRight();
+	}
+	else if (!game.IsMoveDownHeld())
+	{
+		MoveDownPressed();
 	}
-	NextSymbolIndicies.Empty();
+}
+
+void APrototypePawn::CancelHint()
+{
+	// the search under way stops at its next check, and nothing reads its result
+	if (HintCancel.IsValid()) *HintCancel = true;
+	HintCancel.Reset();
+	HintSearch = TFuture<FColumnsHint>();
+	bHintShown = false;
+
+	HintComponentPool.ReleaseAll();
+	HintComponentPool.HideReleased();
+}
+
+void APrototypePawn::ConstructTrinity()
+{
+	// take back the symbol components to reuse them; they're handed out in the same order every time
+	MeshComponentPool.ReleaseAll();
+	CurrentPawnStaticMeshComponents.Reset();
+	NextPawnStaticMeshComponents.Reset();
+
+	APrototypeGameModeBase* gameMode = (APrototypeGameModeBase*)GetWorld()->GetAuthGameMode();
+	if (gameMode == nullptr) return;
+
+	// count the objects created over the last move
+	gameMode->UpdateMoveStats();
+
+	// the trinity is drawn where the game has it, at the top of the board unless it was restored mid fall
+	const FColumnsGame& game = gameMode->GetGame();
+	SimulatedLocation = FVector(game.GetLocationX() * GAME_BOARD_SPACING, game.GetLocationY() * GAME_BOARD_SPACING + game.GetFallProgress() / 1000.0f, 0.0f);
+	PreviousSimulatedLocation = SimulatedLocation;
+
+	// the next trinity needs its own search
+	AutoPlaySearch = TFuture<FColumnsSearchResult>();
+	bAutoPlayTargetSet = false;
 
 	// construct the current trinity of symbols
-	int32 stack = 1;
-	for (auto index = 0; index < PAWN_SIZE; index++)
+	CurrentSymbolIndicies = game.GetCurrentSymbolIndicies();
+	for (auto index = 0; index < CurrentSymbolIndicies.Num(); index++)
 	{
-		const FName uniqueName = FName(*FString::Printf(TEXT("CurrentMeshComponent%d"), stack++));
-		UStaticMeshComponent* newComponent = NewObject<UStaticMeshComponent>(this, uniqueName);
-
-		if (newComponent != nullptr)
-		{
-			CurrentPawnStaticMeshComponents.Add(newComponent);
-			newComponent->RegisterComponent();
-			newComponent->SetStaticMesh(SymbolStaticMeshArray[CurrentSymbolIndicies[index]]);
+		UStaticMeshComponent* component = index == 0
+			? MeshComponentPool.Acquire(this, GetRootComponent(), SymbolStaticMeshArray[CurrentSymbolIndicies[index]], SimulatedLocation)
+			: MeshComponentPool.Acquire(this, CurrentPawnStaticMeshComponents[0], SymbolStaticMeshArray[CurrentSymbolIndicies[index]], FVector(0.0f, index * GAME_BOARD_SPACING, 0.0f));
 
-			if (index == 0)
-			{
-				newComponent->SetRelativeLocation(FVector(0.0f, LocationY * GAME_BOARD_SPACING, 0.0f));
-				newComponent->AttachToComponent(GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
-			}
-			else
-			{
-				newComponent->SetRelativeLocation(FVector(0.0f, index * GAME_BOARD_SPACING, 0.0f));
-				newComponent->AttachToComponent(CurrentPawnStaticMeshComponents[0], FAttachmentTransformRules::KeepRelativeTransform);
-			}
-		}
+		if (component != nullptr) CurrentPawnStaticMeshComponents.Add(component);
 	}
 
 	// construct the next trinity of symbols
-	stack = 1;
-	for (auto index = 0; index < PAWN_SIZE; index++)
+	const TArray<int32>& nextSymbolIndicies = game.GetNextSymbolIndicies();
+	for (auto index = 0; index < nextSymbolIndicies.Num(); index++)
 	{
-		const FName uniqueName = FName(*FString::Printf(TEXT("NextMeshComponent%d"), stack++));
-		UStaticMeshComponent* newComponent = NewObject<UStaticMeshComponent>(this, uniqueName);
+		UStaticMeshComponent* component = MeshComponentPool.Acquire(this, GetRootComponent(), SymbolStaticMeshArray[nextSymbolIndicies[index]], FVector(GAME_BOARD_SPACING * -4, (index + 2) * GAME_BOARD_SPACING, 0.0f));
 
-		if (newComponent != nullptr)
-		{
-			NextPawnStaticMeshComponents.Add(newComponent);
-			newComponent->RegisterComponent();
-			newComponent->SetRelativeLocation(FVector(GAME_BOARD_SPACING * -4, (index + 2) * GAME_BOARD_SPACING, 0.0f));
-			
-			const int32 symbolIndex = rand() % SymbolStaticMeshArray.Num();
-			newComponent->SetStaticMesh(SymbolStaticMeshArray[symbolIndex]);
-			newComponent->AttachToComponent(GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
-
-			NextSymbolIndicies.Add(symbolIndex);
-		}
+		if (component != nullptr) NextPawnStaticMeshComponents.Add(component);
 	}
+
+	MeshComponentPool.HideReleased();
+
+	// the last trinity's hint no longer applies; the search for this one waits for the board to settle
+	CancelHint();
 }
 
 void APrototypePawn::MoveDownPressed()
 {
-	if (GameBoardActor != nullptr)
-	{
-		// check if above the bottom row and there's room to move down
-		if ((LocationY + PAWN_SIZE) < GAME_BOARD_NUMBER_OF_ROWS && GameBoardActor->BoardGet(LocationY + PAWN_SIZE, LocationX) == 0)
-		{
-			DesiredLocationY = LocationY + 1;
-			MoveDownKeyHeldDown = true;
-		}
-	}
+	ApplyInput(EColumnsInput::MOVE_DOWN_PRESSED);
 }
 
 void APrototypePawn::MoveDownReleased()
 {
-	MoveDownKeyHeldDown = false;
+	ApplyInput(EColumnsInput::MOVE_DOWN_RELEASED);
 }
 
 void APrototypePawn::MoveLeft()
 {
-	// check if it's possible to move left
-	if (GameBoardActor != nullptr)
-	{
-		if (LocationX > 0)
-		{
-			int32 row;
-			for (row = LocationY; row < LocationY + PAWN_SIZE; row++)
-			{
-				if (GameBoardActor->BoardGet(row, LocationX - 1) != 0)	break;
-			}
-
-			if (row == (LocationY + PAWN_SIZE))
-			{
-				DesiredLocationX = LocationX - 1;
-			}
-		}
-	}
+	ApplyInput(EColumnsInput::MOVE_LEFT);
 }
 
 void APrototypePawn::MoveRight()
 {
-	// check if it's possible to move right
-	if (GameBoardActor != nullptr)
-	{
-		if (LocationX < (GAME_BOARD_NUMBER_OF_COLUMNS - 1))
-		{
-			int32 row;
-			for (row = LocationY; row < LocationY + PAWN_SIZE; row++)
-			{
-				if (GameBoardActor->BoardGet(row, LocationX + 1) != 0)	break;
-			}
+	ApplyInput(EColumnsInput::MOVE_RIGHT);
+}
 
-			if (row == (LocationY + PAWN_SIZE))
-			{
-				DesiredLocationX = LocationX + 1;
-			}
-		}
-	}
+void APrototypePawn::RewindMove()
+{
+	APrototypeGameModeBase* gameMode = (APrototypeGameModeBase*)GetWorld()->GetAuthGameMode();
+	if (gameMode == nullptr) return;
+
+	// the newest snapshot is the start of the falling trinity, so one back is the start of the last one
+	if (gameMode->Rewind(1)) ShowGame();
 }
 
 void APrototypePawn::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -189,125 +196,218 @@ void APrototypePawn::SetupPlayerInputComponent(UInputComponent* PlayerInputCompo
 	InputComponent->BindAction("MoveDown", EInputEvent::IE_Released, this, &APrototypePawn::MoveDownReleased);
 	InputComponent->BindAction("MoveLeft", EInputEvent::IE_Pressed, this, &APrototypePawn::MoveLeft);
 	InputComponent->BindAction("MoveRight", EInputEvent::IE_Pressed, this, &APrototypePawn::MoveRight);
+	InputComponent->BindAction("Rewind", EInputEvent::IE_Pressed, this, &APrototypePawn::RewindMove);
 	InputComponent->BindAction("ShuffleDown", EInputEvent::IE_Pressed, this, &APrototypePawn::ShuffleDown);
 	InputComponent->BindAction("ShuffleUp", EInputEvent::IE_Pressed, this, &APrototypePawn::ShuffleUp);
+	InputComponent->BindAction("ToggleHint", EInputEvent::IE_Pressed, this, &APrototypePawn::ToggleHint);
 }
 
-void APrototypePawn::ShuffleDown()
+void APrototypePawn::ShowGame()
 {
-	// shuffle the current symbols down
-	if (CurrentSymbolIndicies.Num() == PAWN_SIZE && CurrentPawnStaticMeshComponents.Num() == PAWN_SIZE)
+	if (GameBoardActor != nullptr) GameBoardActor->ShowBoard();
+
+	ConstructTrinity();
+	if (bShowHint) StartHintSearch();
+
+	PrimaryActorTick.SetTickFunctionEnable(true);
+	EnableInput(GetWorld()->GetFirstPlayerController());
+}
+
+void APrototypePawn::ShowTrinitySymbols()
+{
+	APrototypeGameModeBase* gameMode = (APrototypeGameModeBase*)GetWorld()->GetAuthGameMode();
+	if (gameMode == nullptr) return;
+
+	CurrentSymbolIndicies = gameMode->GetGame().GetCurrentSymbolIndicies();
+	for (auto index = 0; index < CurrentSymbolIndicies.Num() && index < CurrentPawnStaticMeshComponents.Num(); index++)
 	{
-		const int32 swap = CurrentSymbolIndicies.Last();
-		CurrentSymbolIndicies.Insert(swap, 0);
-		CurrentSymbolIndicies.RemoveAt(CurrentSymbolIndicies.Num() - 1);
-		
-		UStaticMesh *staticMeshHolder = CurrentPawnStaticMeshComponents.Last()->GetStaticMesh();
-		for (auto index = CurrentPawnStaticMeshComponents.Num() - 1; index > 0; index--)
-		{
-			CurrentPawnStaticMeshComponents[index]->SetStaticMesh(CurrentPawnStaticMeshComponents[index - 1]->GetStaticMesh());
-		}
-		CurrentPawnStaticMeshComponents[0]->SetStaticMesh(staticMeshHolder);
+		CurrentPawnStaticMeshComponents[index]->SetStaticMesh(SymbolStaticMeshArray[CurrentSymbolIndicies[index]]);
 	}
 }
 
+void APrototypePawn::ShuffleDown()
+{
+	ApplyInput(EColumnsInput::SHUFFLE_DOWN);
+}
+
 void APrototypePawn::ShuffleUp()
 {
-	// shuffle the current symbols up
-	if (CurrentSymbolIndicies.Num() == PAWN_SIZE && CurrentPawnStaticMeshComponents.Num() == PAWN_SIZE)
+	ApplyInput(EColumnsInput::SHUFFLE_UP);
+}
+
+void APrototypePawn::StartHintSearch()
+{
+	CancelHint();
+
+	APrototypeGameModeBase* gameMode = (APrototypeGameModeBase*)GetWorld()->GetAuthGameMode();
+	if (gameMode == nullptr || gameMode->GetGame().IsGameOver()) return;
+
+	// the task searches a copy of the game, so the game can carry on under it
+	const FColumnsGame game = gameMode->GetGame();
+	HintBoardHash = game.GetBoard().GetHash();
+
+	TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> cancel = MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(false);
+	HintCancel = cancel;
+
+	FColumnsSearchSettings searchSettings;
+	searchSettings.MaxDepth = HintDepth;
+	searchSettings.BudgetSeconds = HintBudgetSeconds;
+	searchSettings.Cancel = cancel.Get();
+
+	if (!AutoPlayTable.IsValid()) AutoPlayTable = MakeShared<FColumnsTranspositionTable, ESPMode::ThreadSafe>(18);
+
+	// the task keeps its own references, so it can outlive the trinity or the pawn it was started for
+	const uint32 seed = gameMode->GetSearchSeed();
+	TSharedPtr<FColumnsTranspositionTable, ESPMode::ThreadSafe> table = AutoPlayTable;
+	HintSearch = Async(EAsyncExecution::ThreadPool, [game, searchSettings, seed, table, cancel]()
 	{
-		const int32 swap = CurrentSymbolIndicies[0];
-		CurrentSymbolIndicies.RemoveAt(0);
-		CurrentSymbolIndicies.Add(swap);
+		FColumnsHint hint;
+		hint.Placement = FColumnsSearch(searchSettings, table.Get()).Search(game, seed).Placement;
 
-		UStaticMesh* staticMeshHolder = CurrentPawnStaticMeshComponents[0]->GetStaticMesh();
-		for (auto index = 0; index < PAWN_SIZE - 1; index++)
+		// a shuffle down moves the last symbol to the top
+		hint.SymbolIndicies = game.GetCurrentSymbolIndicies();
+		for (auto index = 0; index < hint.Placement.ShuffleDowns; index++)
 		{
-			CurrentPawnStaticMeshComponents[index]->SetStaticMesh(CurrentPawnStaticMeshComponents[index + 1]->GetStaticMesh());
+			hint.SymbolIndicies.Insert(hint.SymbolIndicies.Pop(), 0);
 		}
-		CurrentPawnStaticMeshComponents.Last()->SetStaticMesh(staticMeshHolder);
+
+		FColumnsGame trial = game;
+		hint.Row = trial.DropPiece(hint.Placement.Column, hint.Placement.ShuffleDowns) ? trial.GetLastLandedRow() : -PAWN_SIZE;
+		return hint;
+	});
+}
+
+void APrototypePawn::StepSimulation()
+{
+	APrototypeGameModeBase* gameMode = (APrototypeGameModeBase*)GetWorld()->GetAuthGameMode();
+	if (gameMode == nullptr) return;
+
+	if (bAutoPlay) AutoPlayTick();
+
+	// the game moves the trinity down under gravity, or quickly if move down is held, and lands it
+	if (gameMode->AdvanceGame(PAWN_STEP_MS))
+	{
+		TriggerNextMoveStart();
+		return;
 	}
+
+	// the drawn trinity follows the fall exactly, and slides across to a new column at the pawn speed
+	const FColumnsGame& game = gameMode->GetGame();
+	SimulatedLocation.X = FMath::FInterpConstantTo(SimulatedLocation.X, game.GetLocationX() * GAME_BOARD_SPACING, PAWN_STEP_SECONDS, PAWN_SPEED_PIXELS_PER_SECOND);
+	SimulatedLocation.Y = game.GetLocationY() * GAME_BOARD_SPACING + game.GetFallProgress() / 1000.0f;
+}
+
+void APrototypePawn::ToggleHint()
+{
+	bShowHint = !bShowHint;
+
+	if (bShowHint) StartHintSearch();
+	else CancelHint();
 }
 
 void APrototypePawn::Tick(float DeltaTime)
 {
+	SCOPE_CYCLE_COUNTER(STAT_ColumnsPawnTick);
+	TRACE_CPUPROFILER_EVENT_SCOPE(ColumnsPawnTick);
+
 	Super::Tick(DeltaTime);
 
-	// check left/right movement
-	if (DesiredLocationX > LocationX) {
-		CurrentPawnStaticMeshComponents[0]->AddRelativeLocation(FVector(DeltaTime * PAWN_SPEED_PIXELS_PER_SECOND, 0.0f, 0.0f));
-		if (CurrentPawnStaticMeshComponents[0]->GetRelativeTransform().GetLocation().X >= DesiredLocationX * GAME_BOARD_SPACING)
-		{
-			LocationX = DesiredLocationX;
-			const float currentY = CurrentPawnStaticMeshComponents[0]->GetRelativeTransform().GetLocation().Y;
-			CurrentPawnStaticMeshComponents[0]->SetRelativeLocation(FVector(LocationX * GAME_BOARD_SPACING, currentY, 0.0f));
-		}
-	}
-	else if (DesiredLocationX < LocationX)
-	{
-		CurrentPawnStaticMeshComponents[0]->AddRelativeLocation(FVector(-DeltaTime * PAWN_SPEED_PIXELS_PER_SECOND, 0.0f, 0.0f));
-		if (CurrentPawnStaticMeshComponents[0]->GetRelativeTransform().GetLocation().X <= DesiredLocationX * GAME_BOARD_SPACING)
-		{
-			LocationX = DesiredLocationX;
-			const float currentY = CurrentPawnStaticMeshComponents[0]->GetRelativeTransform().GetLocation().Y;
-			CurrentPawnStaticMeshComponents[0]->SetRelativeLocation(FVector(LocationX * GAME_BOARD_SPACING, currentY, 0.0f));
-		}
-	}
+	UpdateHint();
+
+	APrototypeGameModeBase* gameMode = (APrototypeGameModeBase*)GetWorld()->GetAuthGameMode();
+	const int32 turboMultiplier = gameMode != nullptr ? gameMode->GetTurboMultiplier() : 1;
 
-	// trigger speeder downward movement if down key held
-	if (MoveDownKeyHeldDown && DesiredLocationY == LocationY)
+	// the game moves in fixed steps whatever the frame rate; a hitch longer than the catch up is dropped
+	// rather than run as a burst of steps
+	const int64 stepMicroseconds = PAWN_STEP_MS * 1000;
+	const int64 maxMicroseconds = (int64)PAWN_MAX_CATCH_UP_MS * 1000 * turboMultiplier;
+	SimulationMicroseconds = FMath::Min(SimulationMicroseconds + (int64)FMath::RoundToInt(DeltaTime * 1000000.0f) * turboMultiplier, maxMicroseconds);
+
+	int32 stepsTaken = 0;
+	while (SimulationMicroseconds >= stepMicroseconds)
 	{
-		DesiredLocationY++;
+		PreviousSimulatedLocation = SimulatedLocation;
+		StepSimulation();
+		SimulationMicroseconds -= stepMicroseconds;
+		stepsTaken++;
+
+		// a landing hands over to the board's cascade, and the steps left wait for the next trinity; a fast
+		// forwarded one has already given it back
+		if (!PrimaryActorTick.IsTickFunctionEnabled()) break;
 	}
-	
-	// check down movement
-	if (DesiredLocationY > LocationY)
+	SET_DWORD_STAT(STAT_ColumnsPawnSteps, stepsTaken);
+
+	// draw the trinity between the last two steps, by how far the clock is into the next one
+	if (CurrentPawnStaticMeshComponents.Num() > 0)
 	{
-		CurrentPawnStaticMeshComponents[0]->AddRelativeLocation(FVector(0.0f, DeltaTime * PAWN_SPEED_PIXELS_PER_SECOND, 0.0f));
-		if (CurrentPawnStaticMeshComponents[0]->GetRelativeTransform().GetLocation().Y >= DesiredLocationY * GAME_BOARD_SPACING)
-		{
-			LocationY = DesiredLocationY;
-			const float currentX = CurrentPawnStaticMeshComponents[0]->GetRelativeTransform().GetLocation().X;
-			CurrentPawnStaticMeshComponents[0]->SetRelativeLocation(FVector(currentX, LocationY * GAME_BOARD_SPACING, 0.0f));
-		}
+		const float alpha = FMath::Clamp((float)SimulationMicroseconds / stepMicroseconds, 0.0f, 1.0f);
+		CurrentPawnStaticMeshComponents[0]->SetRelativeLocation(FMath::Lerp(PreviousSimulatedLocation, SimulatedLocation, alpha));
 	}
-	else
+}
+
+void APrototypePawn::UpdateHint()
+{
+	APrototypeGameModeBase* gameMode = (APrototypeGameModeBase*)GetWorld()->GetAuthGameMode();
+	if (!bShowHint || gameMode == nullptr) return;
+
+	// the cascade of the last landing, a scroll or a new level changed the board the search was started on
+	if (gameMode->GetGame().GetBoard().GetHash() != HintBoardHash)
 	{
-		// add gravity to automatically pull down
-		CurrentPawnStaticMeshComponents[0]->AddRelativeLocation(FVector(0.0f, DeltaTime * GravityPixelsPerSecond, 0.0f));
-		if (CurrentPawnStaticMeshComponents[0]->GetRelativeTransform().GetLocation().Y >= (LocationY + 1) * GAME_BOARD_SPACING)
-		{
-			// if it moves into the next space, update location
-			LocationY++;
-			const float currentX = CurrentPawnStaticMeshComponents[0]->GetRelativeTransform().GetLocation().X;
-			CurrentPawnStaticMeshComponents[0]->SetRelativeLocation(FVector(currentX, LocationY * GAME_BOARD_SPACING, 0.0f));
-		}
+		StartHintSearch();
+		return;
 	}
-	
-	// check if downward collision
-	if (GameBoardActor != nullptr)
+
+	if (bHintShown || !HintSearch.IsValid() || !HintSearch.IsReady()) return;
+
+	// ghost symbols where the trinity would land, in the order it would land in
+	const FColumnsHint& hint = HintSearch.Get();
+	if (hint.SymbolIndicies.Num() == PAWN_SIZE && hint.Row > -PAWN_SIZE)
 	{
-		// check if above the bottom row and there's room to move down
-		if ((LocationY + PAWN_SIZE) >= GAME_BOARD_NUMBER_OF_ROWS || GameBoardActor->BoardGet(LocationY + PAWN_SIZE, LocationX) != 0)
+		for (auto index = 0; index < PAWN_SIZE; index++)
 		{
-			TriggerNextMoveStart();
+			if (hint.Row + index < 0) continue;
+
+			const FVector location(hint.Placement.Column * GAME_BOARD_SPACING, (hint.Row + index) * GAME_BOARD_SPACING, 0.0f);
+			UStaticMeshComponent* component = HintComponentPool.Acquire(this, GetRootComponent(), SymbolStaticMeshArray[hint.SymbolIndicies[index]], location);
+			if (component != nullptr && HintMaterial != nullptr) component->SetMaterial(0, HintMaterial);
 		}
 	}
+
+	bHintShown = true;
 }
 
 void APrototypePawn::TriggerNextMoveEnd()
 {
 	APrototypeGameModeBase* gameMode = (APrototypeGameModeBase*)GetWorld()->GetAuthGameMode();
 
+	// the time from the landing to the next trinity taking input, over every frame of the cascade
+	if (LandCycles != 0)
+	{
+		SET_CYCLE_COUNTER(STAT_ColumnsLandToNextPiece, FPlatformTime::Cycles() - LandCycles);
+		LandCycles = 0;
+	}
+
 	if (gameMode != nullptr)
 	{
-		// check for completion of the level
-		if (gameMode->GetJewels() >= gameMode->GetJewelsRequired())
+		// check for completion of the level; the game has already started the next one, and the board shows it
+		if (gameMode->GetGame().GetLevel() != gameMode->GetLevel())
 		{
-			gameMode->TriggerNextLevel();
-			return;
+			if (!gameMode->IsEndless() && gameMode->IsReloadingEachLevel())
+			{
+				gameMode->TriggerNextLevel();
+				return;
+			}
+
+			gameMode->AdvanceLevel();
+			gameMode->TriggerLevelStarted();
 		}
 
+		// the board has settled and the trinity is at the top; a move can be stepped back to from here
+		gameMode->TakeSnapshot();
+
+		// the cascade has been shown, so the board the hint searches won't change under it again this move
+		if (bShowHint) StartHintSearch();
+
 		// re-enable movement and input
 		PrimaryActorTick.SetTickFunctionEnable(true);
 		EnableInput(GetWorld()->GetFirstPlayerController());
@@ -324,19 +424,19 @@ void APrototypePawn::TriggerNextMoveStart()
 		// disable tick and input while animating
 		PrimaryActorTick.SetTickFunctionEnable(false);
 		DisableInput(GetWorld()->GetFirstPlayerController());
-		
-		// disable held down key while input isn't available
-		MoveDownKeyHeldDown = false;
 
 		// check for game over
-		if (LocationY < 0)
+		const FColumnsGame& game = gameMode->GetGame();
+		if (game.IsGameOver())
 		{
 			gameMode->TriggerEndGame();
 			return;
 		}
 		
-		// add the symbols to the board array, set static mesh components in the board
-		GameBoardActor->BoardSetTrinity(CurrentSymbolIndicies, LocationY, LocationX);
+		LandCycles = FPlatformTime::Cycles();
+
+		// set static mesh components in the board for the symbols that landed
+		GameBoardActor->BoardSetTrinity(CurrentSymbolIndicies, game.GetLastLandedRow(), game.GetLastLandedColumn());
 
 		// construct the next set of board symbols (and move the trinity to not cover animations)
 		ConstructTrinity();
@@ -345,7 +445,3 @@ void APrototypePawn::TriggerNextMoveStart()
 		GameBoardActor->TriggerRemoveCollapseAnimate();
 	}
 }
-
-
-
-
@@ -0,0 +1,147 @@
+// Copyright 2019
+#include "AllocationCounter.h"
+#include "ColumnsGame.h"
+#include "ColumnsPolicy.h"
+#include "ColumnsTimeline.h"
+#include "GameBoardActor.h"
+#include "Misc/AutomationTest.h"
+#include "PrototypePawn.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Moves played before counting, so every scratch array has grown to the biggest cascade it needs.
+constexpr int32 ALLOCATION_TEST_WARM_UP_MOVES = 50;
+
+// Moves counted once warmed up.
+constexpr int32 ALLOCATION_TEST_COUNTED_MOVES = 500;
+
+// Steps a trinity is given to land before the test gives up on it.
+constexpr int32 ALLOCATION_TEST_MAX_STEPS = 100000;
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FColumnsMoveAllocationTest, "Prototype.Columns.MoveAllocations",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Returns where the board shows a cell's symbol, as the game board lays them out.
+static FVector GetCellLocation(int32 row, int32 column)
+{
+	return FVector(column * GAME_BOARD_SPACING, 0.0f, -row * GAME_BOARD_SPACING);
+}
+
+// Play back the last landing's cascade the way the game board does: highlight each step's removed symbols,
+// then drop its falling symbols, running the timeline to the end of each at the pawn's step.
+static void PlayBackCascade(const FColumnsCascade& cascade, int32 numberOfColumns, FColumnsTimeline& timeline)
+{
+	for (auto stepIndex = 0; stepIndex < cascade.GetNumberOfSteps(); stepIndex++)
+	{
+		const FColumnsCascadeStep& step = cascade.GetStep(stepIndex);
+
+		timeline.Reset();
+		for (auto index = step.FirstRemoved; index < step.FirstRemoved + step.NumberOfRemoved; index++)
+		{
+			const FRowColumn& location = cascade.GetRemoved(index);
+			const FVector cellLocation = GetCellLocation(location.Row, location.Column);
+			timeline.AddTrack(location.Row * numberOfColumns + location.Column, cellLocation, cellLocation, SYMBOL_HIGHLIGHT_SECONDS);
+		}
+		while (!timeline.Advance(PAWN_STEP_SECONDS));
+
+		timeline.Reset();
+		for (auto index = step.FirstFall; index < step.FirstFall + step.NumberOfFalls; index++)
+		{
+			const FSymbolFall& fall = cascade.GetFall(index);
+			const float durationSeconds = (fall.ToRow - fall.FromRow) * GAME_BOARD_SPACING / PAWN_SPEED_PIXELS_PER_SECOND;
+			timeline.AddTrack(fall.FromRow * numberOfColumns + fall.Column, GetCellLocation(fall.FromRow, fall.Column),
+				GetCellLocation(fall.ToRow, fall.Column), durationSeconds);
+		}
+
+		// the board moves every falling instance each frame
+		bool bFinished = false;
+		while (!bFinished)
+		{
+			bFinished = timeline.Advance(PAWN_STEP_SECONDS);
+			for (auto index = 0; index < timeline.GetNumberOfTracks(); index++)
+			{
+				timeline.GetLocation(index);
+			}
+		}
+	}
+}
+
+// Steer the trinity to a placement one input per step, as autoplay does, then hold it down until it lands;
+// returns false if it never lands.
+static bool PlayMove(FColumnsGame& game, const FColumnsPlacement& placement)
+{
+	const int32 piecesPlaced = game.GetPiecesPlaced();
+	int32 shuffleDownsLeft = placement.ShuffleDowns;
+
+	for (auto step = 0; step < ALLOCATION_TEST_MAX_STEPS; step++)
+	{
+		// a move that's blocked holds the trinity down instead
+		bool bMoved = false;
+		if (shuffleDownsLeft > 0)
+		{
+			bMoved = game.ApplyInput(EColumnsInput::SHUFFLE_DOWN);
+			shuffleDownsLeft--;
+		}
+		else if (placement.Column < game.GetLocationX())
+		{
+			bMoved = game.ApplyInput(EColumnsInput::MOVE_LEFT);
+		}
+		else if (placement.Column > game.GetLocationX())
+		{
+			bMoved = game.ApplyInput(EColumnsInput::MOVE_RIGHT);
+		}
+
+		if (!bMoved && !game.IsMoveDownHeld()) game.ApplyInput(EColumnsInput::MOVE_DOWN_PRESSED);
+
+		game.AdvanceMs(PAWN_STEP_MS);
+		if (game.IsGameOver() || game.GetPiecesPlaced() != piecesPlaced) return true;
+	}
+
+	return false;
+}
+
+bool FColumnsMoveAllocationTest::RunTest(const FString& Parameters)
+{
+	const FColumnsGameSettings settings;
+	FColumnsGame game;
+	game.Reset(settings, 1);
+
+	// the board actor reserves its timeline for the whole board when it shows a game
+	FColumnsTimeline timeline;
+	timeline.Reserve(settings.NumberOfColumns * settings.NumberOfRows);
+
+	FColumnsRandom random(1);
+	FAllocationCounter allocationCounter;
+	allocationCounter.Register();
+
+	// only the land, match and collapse of each move is counted; choosing the placement and starting a lost
+	// game again aren't part of a move
+	int64 allocations = 0;
+	for (auto move = 0; move < ALLOCATION_TEST_WARM_UP_MOVES + ALLOCATION_TEST_COUNTED_MOVES; move++)
+	{
+		if (game.IsGameOver()) game.Reset(settings, move + 1);
+
+		const FColumnsPlacement placement = FColumnsPolicy::ChoosePlacement(EColumnsPolicy::GREEDY, game, random);
+
+		const int64 allocationsBefore = allocationCounter.GetCount();
+		const bool bLanded = PlayMove(game, placement);
+		if (bLanded) PlayBackCascade(game.GetLastCascade(), settings.NumberOfColumns, timeline);
+		const int64 moveAllocations = allocationCounter.GetCount() - allocationsBefore;
+
+		if (!bLanded)
+		{
+			allocationCounter.Unregister();
+			AddError(FString::Printf(TEXT("Trinity %d never landed."), game.GetPiecesPlaced()));
+			return false;
+		}
+
+		if (move >= ALLOCATION_TEST_WARM_UP_MOVES) allocations += moveAllocations;
+	}
+
+	allocationCounter.Unregister();
+
+	TestEqual(TEXT("Heap allocations landing, matching and collapsing after warming up"), allocations, (int64)0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,87 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/MemoryBase.h"
+
+// The most threads whose allocations can be counted together.
+constexpr int32 ALLOCATION_COUNTER_MAX_THREADS = 64;
+
+// Counts the heap allocations made on the registering thread, and any threads added to it, by standing in
+// front of the global allocator while registered. Every call is passed on to the allocator it replaced, so
+// memory can be freed either side of registering; only the count is added.
+class PROTOTYPE_API FAllocationCounter : public FMalloc
+{
+
+public:
+
+	virtual ~FAllocationCounter();
+
+	// Count the allocations made on another thread too, such as a worker doing part of the measured work;
+	// false if the most threads are already counted. Add it before the thread starts the work.
+	bool AddThread(uint32 threadId);
+
+	// Start counting the allocations made on the calling thread, and on the threads added.
+	void Register();
+
+	// Stop counting and put the global allocator back.
+	void Unregister();
+
+	// Returns the number of allocations made on the counted threads while registered.
+	FORCEINLINE int64 GetCount() const { return FPlatformAtomics::AtomicRead(&Count); }
+
+	virtual void* Malloc(SIZE_T Size, uint32 Alignment) override;
+
+	virtual void* Realloc(void* Original, SIZE_T Size, uint32 Alignment) override;
+
+	virtual void Free(void* Original) override;
+
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override;
+
+	virtual SIZE_T QuantizeSize(SIZE_T Size, uint32 Alignment) override;
+
+	virtual void SetupTLSCachesOnCurrentThread() override;
+
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override;
+
+	virtual bool IsInternallyThreadSafe() const override;
+
+	virtual bool ValidateHeap() override;
+
+	virtual const TCHAR* GetDescriptiveName() override;
+
+	virtual void Trim(bool bTrimThreadCaches) override;
+
+	virtual void InitializeStatsMetadata() override;
+
+	virtual void UpdateStats() override;
+
+	virtual void GetAllocatorStats(FGenericMemoryStats& out_Stats) override;
+
+	virtual void DumpAllocatorStats(class FOutputDevice& Ar) override;
+
+	virtual bool Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar) override;
+
+	virtual void OnMallocInitialized() override;
+
+	virtual void OnPreFork() override;
+
+	virtual void OnPostFork() override;
+
+protected:
+
+	// Returns true if the calling thread's allocations are counted.
+	bool IsCountedThread() const;
+
+	// The number of allocations made on the counted threads.
+	volatile int64 Count = 0;
+
+	// The allocator that was global before registering.
+	FMalloc* Inner = nullptr;
+
+	// The number of threads whose allocations are counted.
+	int32 NumberOfThreads = 0;
+
+	// The threads whose allocations are counted; a fixed array, as it's read inside the allocator.
+	uint32 ThreadIds[ALLOCATION_COUNTER_MAX_THREADS] = {};
+};
@@ -0,0 +1,115 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BoardKernel.h"
+
+class FColumnsBoard;
+
+// The number of boards a batch steps together, one byte of a 128 bit vector each.
+constexpr int32 BOARD_BATCH_LANES = 16;
+
+// The most cells a board in a batch can have, as each lane counts the cells it removes in a byte.
+constexpr int32 BOARD_BATCH_MAX_CELLS = 255;
+
+// The match and collapse loops of a batch of boards for one instruction set: SSE2 takes a cell of every
+// board a vector, AVX2 two cells, and the scalar fallback goes a byte at a time. Works on cells interleaved
+// by board, BOARD_BATCH_LANES bytes per cell with a byte per board, 0 for empty and >0 for a symbol, and on
+// flags laid out the same way, 0xFF for set.
+struct PROTOTYPE_API FBoardBatchKernel
+{
+	// Returns the fastest kernel the CPU can run.
+	static const FBoardBatchKernel& Best();
+
+	// Returns the kernel with a name (scalar, sse2 or avx2), or nullptr if there isn't one the CPU can run.
+	static const FBoardBatchKernel* Find(const FString& name);
+
+	// The instruction set, for logs and benchmark results.
+	const TCHAR* Name;
+
+	// Compact each column of every board, flagging the cells symbols fall into as dirty; returns true if
+	// any symbol fell.
+	bool (*CollapseEmpty)(int32 numberOfColumns, int32 numberOfRows, uint8* cells, uint8* dirty);
+
+	// Flag every cell of a run of matchLength matching symbols with a dirty cell in it, for the runs going
+	// step cells at a time from each cell flagged in runStarts.
+	void (*FindRuns)(int32 numberOfCells, int32 step, int32 matchLength, const uint8* runStarts,
+		const uint8* cells, const uint8* dirty, uint8* outMatches);
+
+	// Empty the flagged cells, clear every dirty and match flag, and add the cells each board removed to
+	// its byte of outRemoved; returns true if any cell was removed.
+	bool (*RemoveFlagged)(int32 numberOfCells, uint8* cells, uint8* dirty, uint8* matches, uint8* outRemoved);
+};
+
+// Up to BOARD_BATCH_LANES boards of the same size stepped through the board's match and collapse rules
+// together by a batch kernel. Boards are copied in and out of lanes, so any simulation playing many games
+// at once can resolve their cascades in one go; an unused lane is left empty and costs the same as a full one.
+class PROTOTYPE_API FBoardBatch
+{
+
+public:
+
+	// Returns true if boards of this size and number of symbols fit in a batch.
+	static bool Fits(int32 numberOfColumns, int32 numberOfRows, int32 numberOfSymbols);
+
+	// Compact each column of every lane as the board's collapse empty does; returns true if any symbol fell.
+	bool CollapseEmpty();
+
+	// Returns the symbol at the row and column of a lane; 0 if empty.
+	int32 Get(int32 lane, int32 row, int32 column) const;
+
+	// Size the batch for boards that fit, empty every lane, and pick the kernel; the best the CPU can run if none is given.
+	void Init(int32 numberOfColumns, int32 numberOfRows, const FBoardBatchKernel* kernel = nullptr);
+
+	// Copy the cells of a board of the batch's size into a lane, with its dirty cells.
+	void LoadBoard(int32 lane, const FColumnsBoard& board);
+
+	// Remove the runs of 3 or more through dirty cells in every lane as the board's remove matches does;
+	// outRemoved is given the number of cells each lane removed. Returns true if any lane removed a cell.
+	bool RemoveMatches(uint8 (&outRemoved)[BOARD_BATCH_LANES]);
+
+	// Remove and collapse until every lane settles; outJewels and outDepth are given the cells each lane
+	// removed and its number of removal steps.
+	void ResolveCascade(int32 (&outJewels)[BOARD_BATCH_LANES], int32 (&outDepth)[BOARD_BATCH_LANES]);
+
+	// Set the symbol at the row and column of a lane, flagging a placed symbol dirty as the board's set does.
+	void Set(int32 lane, int32 row, int32 column, int32 symbol);
+
+	// Copy a lane back into a board of the batch's size, setting only the cells that changed so the board's
+	// hash and bitboard follow, and leaving the lane's dirty cells dirty.
+	void StoreBoard(int32 lane, FColumnsBoard& board) const;
+
+	FORCEINLINE const FBoardBatchKernel& GetKernel() const { return *Kernel; }
+
+	FORCEINLINE int32 GetNumberOfColumns() const { return NumberOfColumns; }
+
+	FORCEINLINE int32 GetNumberOfRows() const { return NumberOfRows; }
+
+protected:
+
+	// The symbols of every lane, a cell at a time; padded past the last cell with empty cells for the runs
+	// and vectors that read off the end of the board.
+	TArray<uint8> Cells;
+
+	// The dirty flags of every lane, laid out as the cells.
+	TArray<uint8> Dirty;
+
+	// The kernel the batch runs on.
+	const FBoardBatchKernel* Kernel = nullptr;
+
+	// The cells flagged for removal by the last match search, laid out as the cells.
+	TArray<uint8> Matches;
+
+	// The number of columns of the boards.
+	int32 NumberOfColumns = 0;
+
+	// The number of rows of the boards.
+	int32 NumberOfRows = 0;
+
+	// For right, down, down right and down left, the cells whose run in that direction stays on the board,
+	// flagged in every lane.
+	TArray<uint8> RunStarts[4];
+
+	// The cells between one symbol of a run and the next, for each direction.
+	int32 RunSteps[4] = {};
+};
@@ -0,0 +1,108 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FRowColumn.h"
+
+// The maximum number of unique symbols the bitboard keeps a mask for.
+constexpr int32 BITBOARD_MAX_SYMBOLS = 8;
+
+// A 128 bit mask stored as two 64 bit halves; bit 0 is the lowest bit of Low.
+struct FBitboard128
+{
+	uint64 Low = 0;
+	uint64 High = 0;
+
+	FORCEINLINE FBitboard128() {}
+	FORCEINLINE FBitboard128(uint64 inLow, uint64 inHigh) : Low(inLow), High(inHigh) {}
+
+	FORCEINLINE bool IsEmpty() const { return (Low | High) == 0; }
+
+	FORCEINLINE int32 CountBits() const { return (int32)(FMath::CountBits(Low) + FMath::CountBits(High)); }
+
+	FORCEINLINE void SetBit(int32 bit)
+	{
+		if (bit < 64) Low |= (1ull << bit);
+		else High |= (1ull << (bit - 64));
+	}
+
+	FORCEINLINE void ClearBit(int32 bit)
+	{
+		if (bit < 64) Low &= ~(1ull << bit);
+		else High &= ~(1ull << (bit - 64));
+	}
+
+	FORCEINLINE bool TestBit(int32 bit) const
+	{
+		return bit < 64 ? (Low & (1ull << bit)) != 0 : (High & (1ull << (bit - 64))) != 0;
+	}
+
+	// Remove the lowest set bit and return its index; mask must not be empty.
+	FORCEINLINE int32 PopLowestBit()
+	{
+		if (Low != 0)
+		{
+			const int32 bit = (int32)FMath::CountTrailingZeros64(Low);
+			Low &= Low - 1;
+			return bit;
+		}
+
+		const int32 bit = (int32)FMath::CountTrailingZeros64(High) + 64;
+		High &= High - 1;
+		return bit;
+	}
+
+	FORCEINLINE FBitboard128 operator&(const FBitboard128& other) const { return FBitboard128(Low & other.Low, High & other.High); }
+	FORCEINLINE FBitboard128 operator|(const FBitboard128& other) const { return FBitboard128(Low | other.Low, High | other.High); }
+	FORCEINLINE FBitboard128 operator~() const { return FBitboard128(~Low, ~High); }
+	FORCEINLINE FBitboard128& operator&=(const FBitboard128& other) { Low &= other.Low; High &= other.High; return *this; }
+	FORCEINLINE FBitboard128& operator|=(const FBitboard128& other) { Low |= other.Low; High |= other.High; return *this; }
+
+	FORCEINLINE FBitboard128 operator<<(int32 shift) const
+	{
+		if (shift == 0) return *this;
+		if (shift >= 64) return FBitboard128(0, Low << (shift - 64));
+		return FBitboard128(Low << shift, (High << shift) | (Low >> (64 - shift)));
+	}
+
+	FORCEINLINE FBitboard128 operator>>(int32 shift) const
+	{
+		if (shift == 0) return *this;
+		if (shift >= 64) return FBitboard128(High >> (shift - 64), 0);
+		return FBitboard128((Low >> shift) | (High << (64 - shift)), High >> shift);
+	}
+
+	FORCEINLINE bool operator==(const FBitboard128& other) const { return Low == other.Low && High == other.High; }
+	FORCEINLINE bool operator!=(const FBitboard128& other) const { return !(*this == other); }
+};
+
+// One occupancy mask per symbol for a game board, used to find runs of matching symbols with shifts.
+// Cells are stored row by row with an always empty guard column at the end of each row, so a
+// shifted run can never wrap from the end of one row into the start of the next.
+struct PROTOTYPE_API FBoardBitboard
+{
+	// Returns true if a board of these dimensions and symbol count fits in the masks.
+	static bool Fits(int32 numberOfColumns, int32 numberOfRows, int32 numberOfSymbols);
+
+	// Find every cell that is part of a horizontal, vertical or diagonal run of 3 or more
+	// that passes through at least one cell of the dirty mask.
+	FBitboard128 FindMatches(const FBitboard128& dirty) const;
+
+	// Convert a mask of cells into row and column locations, in row-major order.
+	void MaskToLocations(FBitboard128 mask, TArray<FRowColumn>& outLocations) const;
+
+	// Clear all masks and set the dimensions of the board.
+	void Reset(int32 numberOfColumns, int32 numberOfRows);
+
+	// Update the masks for a cell changing from one symbol to another; 0 is empty.
+	void Set(int32 row, int32 column, int32 oldSymbol, int32 newSymbol);
+
+	// Returns the bit that stores the cell at row, column.
+	FORCEINLINE int32 GetBit(int32 row, int32 column) const { return row * Stride + column; }
+
+	// Occupancy mask for each symbol; index 0 holds symbol 1.
+	FBitboard128 Symbols[BITBOARD_MAX_SYMBOLS];
+
+	// Number of bits per row; the number of columns plus the guard column.
+	int32 Stride = 0;
+};
@@ -0,0 +1,156 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FRowColumn.h"
+#include "FSymbolFall.h"
+
+// The length of the shortest run of matching symbols that is removed.
+constexpr int32 GAME_BOARD_MATCH_LENGTH = 3;
+
+// Calls a functor with 0 to Count - 1 in order, expanded at compile time so the calls are inlined
+// with constant arguments.
+template <int32 Count>
+struct TBoardUnroll
+{
+	template <typename FunctorType>
+	static FORCEINLINE void Loop(FunctorType&& functor)
+	{
+		TBoardUnroll<Count - 1>::Loop(functor);
+		functor(Count - 1);
+	}
+};
+
+template <>
+struct TBoardUnroll<0>
+{
+	template <typename FunctorType>
+	static FORCEINLINE void Loop(FunctorType&&) {}
+};
+
+// Returns true if a bit of a TBitArray's words is set.
+FORCEINLINE bool BoardKernelTestBit(const uint32* words, int32 bit)
+{
+	return (words[bit >> 5] & (1u << (bit & 31))) != 0;
+}
+
+// Sets a bit of a TBitArray's words.
+FORCEINLINE void BoardKernelSetBit(uint32* words, int32 bit)
+{
+	words[bit >> 5] |= 1u << (bit & 31);
+}
+
+// Sets the bit of a matched cell, adding its location the first time.
+FORCEINLINE void BoardKernelAddMatch(uint32* matchBits, int32 numberOfColumns, int32 index, TArray<FRowColumn>& outLocations)
+{
+	if (BoardKernelTestBit(matchBits, index)) return;
+
+	BoardKernelSetBit(matchBits, index);
+	outLocations.Add(FRowColumn(index / numberOfColumns, index % numberOfColumns));
+}
+
+// The match and collapse loops of a board whose dimensions and match length are known at compile time,
+// with every loop over the cells unrolled and every bounds check folded away. Works on the raw cells of
+// a board, row by row, 0 for empty and >0 for a symbol.
+template <int32 Cols, int32 Rows, int32 MatchLen>
+struct TBoardKernel
+{
+	static_assert(Cols > 0 && Rows > 0 && MatchLen > 1, "A board kernel needs a board and runs of at least 2.");
+
+	// Compact each column so symbols above empty spaces drop in one pass; adds each symbol's fall.
+	static void CollapseEmpty(int32* cells, TArray<FSymbolFall>& outFalls)
+	{
+		TBoardUnroll<Cols>::Loop([&](int32 column)
+		{
+			int32 destinationRow = Rows - 1;
+
+			TBoardUnroll<Rows>::Loop([&](int32 rowFromBottom)
+			{
+				const int32 row = Rows - 1 - rowFromBottom;
+				const int32 symbol = cells[row * Cols + column];
+				if (symbol == 0) return;
+
+				if (row != destinationRow)
+				{
+					cells[destinationRow * Cols + column] = symbol;
+					cells[row * Cols + column] = 0;
+					outFalls.Add(FSymbolFall(column, row, destinationRow));
+				}
+
+				destinationRow--;
+			});
+		});
+	}
+
+	// Add every cell in a run of MatchLen matching symbols through a dirty cell, once each, setting its bit
+	// in the match bits; the caller clears the bits of the locations afterwards. Only the runs around the
+	// dirty cells are looked at, so the cost tracks the changed cells rather than the board.
+	static void FindMatches(const int32* cells, const FRowColumn* dirtyCells, int32 numberOfDirtyCells, uint32* matchBits, TArray<FRowColumn>& outLocations)
+	{
+		for (auto index = 0; index < numberOfDirtyCells; index++)
+		{
+			const int32 row = dirtyCells[index].Row;
+			const int32 column = dirtyCells[index].Column;
+			if (cells[row * Cols + column] == 0) continue;
+
+			AddRunsThrough<0, 1>(cells, matchBits, row, column, outLocations);
+			AddRunsThrough<1, 0>(cells, matchBits, row, column, outLocations);
+			AddRunsThrough<1, 1>(cells, matchBits, row, column, outLocations);
+			AddRunsThrough<1, -1>(cells, matchBits, row, column, outLocations);
+		}
+	}
+
+protected:
+
+	// Add the runs along the line stepping by RowStep, ColumnStep that have the cell at row, column in them,
+	// if they match.
+	template <int32 RowStep, int32 ColumnStep>
+	static FORCEINLINE void AddRunsThrough(const int32* cells, uint32* matchBits, int32 row, int32 column, TArray<FRowColumn>& outLocations)
+	{
+		constexpr int32 step = RowStep * Cols + ColumnStep;
+		const int32 symbol = cells[row * Cols + column];
+
+		// from the run starting at the cell back to the run ending at it
+		TBoardUnroll<MatchLen>::Loop([&](int32 offset)
+		{
+			const int32 firstRow = row - RowStep * offset;
+			const int32 firstColumn = column - ColumnStep * offset;
+			const int32 lastColumn = firstColumn + ColumnStep * (MatchLen - 1);
+			if (firstRow < 0 || firstRow + RowStep * (MatchLen - 1) >= Rows
+				|| FMath::Min(firstColumn, lastColumn) < 0 || FMath::Max(firstColumn, lastColumn) >= Cols) return;
+
+			const int32 start = firstRow * Cols + firstColumn;
+			for (auto index = 0; index < MatchLen; index++)
+			{
+				if (cells[start + index * step] != symbol) return;
+			}
+
+			for (auto index = 0; index < MatchLen; index++)
+			{
+				BoardKernelAddMatch(matchBits, Cols, start + index * step, outLocations);
+			}
+		});
+	}
+};
+
+// The kernel functions for a board, either a compile time specialization or the runtime fallback.
+struct PROTOTYPE_API FBoardKernel
+{
+	// Returns the specialized kernel for a board size, or nullptr if there isn't one. The classic 6x13
+	// board and the wide 8x13 and 12x13 boards have their collapse specialized; only 12x13 has its match
+	// search specialized too, as the smaller two fit the bitboard.
+	static const FBoardKernel* Find(int32 numberOfColumns, int32 numberOfRows, int32 matchLength);
+
+	// The runtime fallback of the kernel's collapse, for any board size.
+	static void CollapseEmptyRuntime(int32 numberOfColumns, int32 numberOfRows, int32* cells, TArray<FSymbolFall>& outFalls);
+
+	// The runtime fallback of the kernel's match search, for any board size and match length.
+	static void FindMatchesRuntime(int32 numberOfColumns, int32 numberOfRows, int32 matchLength, const int32* cells,
+		const FRowColumn* dirtyCells, int32 numberOfDirtyCells, uint32* matchBits, TArray<FRowColumn>& outLocations);
+
+	// Compact each column of the cells; adds each symbol's fall.
+	void (*CollapseEmpty)(int32* cells, TArray<FSymbolFall>& outFalls);
+
+	// Add every cell in a matching run through a dirty cell, setting its bit; nullptr to use the runtime fallback.
+	void (*FindMatches)(const int32* cells, const FRowColumn* dirtyCells, int32 numberOfDirtyCells, uint32* matchBits, TArray<FRowColumn>& outLocations);
+};
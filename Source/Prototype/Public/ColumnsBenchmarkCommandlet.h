@@ -0,0 +1,33 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ColumnsBenchmarkCommandlet.generated.h"
+
+// Times the board's core operations in isolation on fixed corpora of board states (sparse, dense,
+// worst case multi-direction matches and long chains), the cascade on batches of boards with each batch
+// kernel (BatchCascade.scalar, .sse2 and .avx2), whole moves on headless games, the greedy policy choosing
+// placements on the best batch kernel, and steps of the vectorized environment with cascades resolved on
+// each game's board and on board batches, and appends the nanoseconds and heap allocations per operation to
+// a CSV file, so runs on different commits can be compared. Fails if a batch kernel's cascade disagrees with
+// the board's, or if a move or an environment step allocates on any of its threads once the games have
+// warmed up.
+//
+// UE4Editor-Cmd Prototype -run=ColumnsBenchmark -nullrhi -label=baseline
+//
+// Options: -boards= (boards per corpus, and games played) -rounds= (passes over each corpus, and moves per
+// game) -filter= (only benchmarks whose name contains this) -columns= -rows= -symbols= -threads= (environment
+// threads besides the caller) -label= (tags the rows, e.g. with a commit) -output=
+UCLASS()
+class PROTOTYPE_API UColumnsBenchmarkCommandlet : public UCommandlet
+{
+
+	GENERATED_BODY()
+
+public:
+
+	UColumnsBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
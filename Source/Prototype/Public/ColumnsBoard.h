@@ -0,0 +1,172 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BoardBitboard.h"
+#include "BoardKernel.h"
+#include "ColumnsRandom.h"
+#include "ColumnsZobrist.h"
+#include "FRowColumn.h"
+#include "FSymbolFall.h"
+
+// Set the game board number of columns (width).
+constexpr int32 GAME_BOARD_NUMBER_OF_COLUMNS = 6;
+
+// Set the game board number of rows (length).
+constexpr int32 GAME_BOARD_NUMBER_OF_ROWS = 13;
+
+// The number of unique symbols in the default game; one per symbol mesh.
+constexpr int32 GAME_BOARD_NUMBER_OF_SYMBOLS = 5;
+
+// Set the space of the grid and distance between elements.
+constexpr float GAME_BOARD_SPACING = 100.0f;
+
+// Used to show which direction adjacent matching symbols are found.
+enum class EDirections : uint8
+{
+	INDETERMINATE,
+	LEFT,
+	DOWN_LEFT,
+	DOWN,
+	DOWN_RIGHT,
+	RIGHT,
+	UP_RIGHT,
+	UP,
+	UP_LEFT,
+};
+
+// The rules of the game board with no dependency on actors, components or the world: a grid of
+// symbols (0 for empty, >0 symbol index + 1) that can be filled, matched and collapsed.
+class PROTOTYPE_API FColumnsBoard
+{
+
+public:
+
+	// Returns the first row that gets random symbols, for a board with filledRows rows of symbols.
+	static int32 GetRowToStartRandomSymbols(int32 numberOfRows, int32 filledRows);
+
+	// Check if there are 3 or more of the same symbol adjacent to location and return direction.
+	EDirections CheckForAdjacentThree(int32 row, int32 column) const;
+
+	// Clear every dirty cell, as if the board had just been checked for matches.
+	void ClearDirty();
+
+	// Compact each column so symbols above empty spaces drop in one pass; outFalls is emptied and given
+	// each symbol's fall, keeping its allocation so a cascade can reuse it every step.
+	void CollapseEmpty(TArray<FSymbolFall>& outFalls);
+
+	// Returns true if symbol at row, column would complete a run of 3 or more with the symbols around it.
+	bool CompletesRun(int32 row, int32 column, int32 symbol) const;
+
+	// Empty the board and fill it with random symbols from rowToStartRandomSymbols down, with no 3 adjacent.
+	void Construct(int32 rowToStartRandomSymbols, FColumnsRandom& random);
+
+	// Fill numberOfRows empty rows from firstRow down with random symbols, picking each from the symbols
+	// that can't make 3 adjacent with each other or with the rows around them.
+	void FillRows(int32 firstRow, int32 numberOfRows, FColumnsRandom& random);
+
+	// Find adjacent matching symbols of 3 or more in lines that pass through a dirty cell; outLocations is
+	// emptied and given them in row-major order.
+	void FindMatches(TArray<FRowColumn>& outLocations) const;
+
+	// Get the symbol located at the row and column; 0 if empty or off the board.
+	int32 Get(const int32 row, const int32 column) const;
+
+	// Size the board and set every cell empty.
+	void Init(int32 numberOfColumns, int32 numberOfRows, int32 numberOfSymbols);
+
+	// Flag a cell as changed so that the next match check looks at the lines through it.
+	void MarkDirty(int32 row, int32 column);
+
+	// Write every cell into words in row-major order, bitsPerCell bits each; no cell straddles two words.
+	void Pack(uint64* words, int32 bitsPerCell) const;
+
+	// Remove adjacent matching symbols of 3 or more through the dirty cells; outLocations is emptied and
+	// given their locations, keeping its allocation.
+	void RemoveMatches(TArray<FRowColumn>& outLocations);
+
+	// Set the symbol at the row and column.
+	void Set(int32 row, int32 column, int32 symbol);
+
+	// Set a trinity of symbol indicies (0 based, as the pawn holds them) into a column from rowStart down.
+	void SetTrinity(const TArray<int32>& symbolsArray, int32 rowStart, int32 column);
+
+	// Replace every cell from words written by pack on a board of the same size, and set the rows retired off
+	// the top of an endless board. The symbols are marked dirty, as filled symbols are.
+	void Unpack(const uint64* words, int32 bitsPerCell, int32 firstRow);
+
+	// Move every row up, dropping the top numberOfRows rows, which must be empty, and leaving empty rows at
+	// the bottom. The symbols keep their neighbours, so nothing new is marked dirty.
+	void RetireRows(int32 numberOfRows);
+
+	// For an endless board: while more than emptyRows rows at the top are empty, retire up to chunkRows of
+	// them and fill the rows that open up at the bottom, until the window reaches the bottom of a board
+	// totalRows tall. Returns the number of rows retired.
+	int32 ScrollEndless(int32 emptyRows, int32 chunkRows, int32 totalRows, FColumnsRandom& random);
+
+	// Returns the first row with a symbol in it, or the number of rows if the board is empty.
+	int32 GetFirstFilledRow() const;
+
+	// Returns the cells in row-major order, 0 for empty and >0 for a symbol.
+	FORCEINLINE const TArray<int32>& GetCells() const { return Cells; }
+
+	// Returns the cells changed since the last match check.
+	FORCEINLINE const TArray<FRowColumn>& GetDirtyCells() const { return DirtyCells; }
+
+	// Returns the row of an endless board that the top row of the board holds; 0 for a board that doesn't scroll.
+	FORCEINLINE int32 GetFirstRow() const { return FirstRow; }
+
+	// Returns the zobrist hash of the symbols on the board, kept up to date by set.
+	FORCEINLINE uint64 GetHash() const { return Hash; }
+
+	FORCEINLINE int32 GetNumberOfColumns() const { return NumberOfColumns; }
+
+	FORCEINLINE int32 GetNumberOfRows() const { return NumberOfRows; }
+
+	FORCEINLINE int32 GetNumberOfSymbols() const { return NumberOfSymbols; }
+
+protected:
+
+	// Add the locations of any runs of 3 or more matching symbols that pass through row, column.
+	void AddMatchesThrough(int32 row, int32 column, TArray<FRowColumn>& locations) const;
+
+	// Update the bitboard and hash for a cell changing from one symbol to another.
+	void CellChanged(int32 index, int32 oldSymbol, int32 newSymbol);
+
+	// Per symbol occupancy masks mirroring the cells, kept in sync by set.
+	FBoardBitboard Bitboard;
+
+	// Whether the board dimensions and symbols fit the bitboard; otherwise matches are found by scanning.
+	bool bUseBitboard = false;
+
+	// The board value array, 0 for empty, and integer for symbol index.
+	TArray<int32> Cells;
+
+	// Cells changed since the last match check; only lines through these can hold a new match.
+	TArray<FRowColumn> DirtyCells;
+
+	// One flag per board cell, set while the cell is in the dirty cells array.
+	TBitArray<> DirtyFlags;
+
+	// One flag per board cell for the match search on boards the bitboard doesn't fit; only set while
+	// finding matches, and sized by init so the search doesn't allocate.
+	mutable TBitArray<> MatchFlags;
+
+	// The number of rows retired off the top of an endless board.
+	int32 FirstRow = 0;
+
+	// The xor of the zobrist keys of every symbol on the board; 0 for an empty board.
+	uint64 Hash = 0;
+
+	// The specialized match and collapse loops for the board size; nullptr to use the runtime fallback.
+	const FBoardKernel* Kernel = nullptr;
+
+	// The number of columns in the game board.
+	int32 NumberOfColumns = GAME_BOARD_NUMBER_OF_COLUMNS;
+
+	// The number of rows in the game board.
+	int32 NumberOfRows = GAME_BOARD_NUMBER_OF_ROWS;
+
+	// The number of unique symbols that can be placed.
+	int32 NumberOfSymbols = GAME_BOARD_NUMBER_OF_SYMBOLS;
+};
@@ -0,0 +1,76 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FRowColumn.h"
+#include "FSymbolFall.h"
+
+class FColumnsBoard;
+
+// One link of a cascade: the matches removed together and the collapse that followed, as ranges of the
+// cascade's removed cells and falls.
+struct FColumnsCascadeStep
+{
+	// The index of the step's first removed cell, and the number it removed; 0 for a collapse on its own.
+	int32 FirstRemoved = 0;
+	int32 NumberOfRemoved = 0;
+
+	// The index of the step's first fall, and the number of symbols that fell.
+	int32 FirstFall = 0;
+	int32 NumberOfFalls = 0;
+};
+
+// A whole cascade resolved in one call. The board is left settled, and the steps that got it there are kept
+// in order as diffs to play back, so anything that only needs the result skips the step by step animation.
+// The arrays keep their allocations from one cascade to the next.
+class PROTOTYPE_API FColumnsCascade
+{
+
+public:
+
+	// Remove matches and collapse until the board settles, recording every step; returns the number of
+	// removal steps.
+	int32 Resolve(FColumnsBoard& board);
+
+	// Make room for the cascades of a board with a number of cells, so resolving doesn't grow the arrays.
+	void Reserve(int32 numberOfCells);
+
+	// Forget the last cascade, for a landing whose cascade was resolved somewhere else.
+	void Reset();
+
+	// Returns the number of removal steps, the depth of the cascade.
+	FORCEINLINE int32 GetDepth() const { return Depth; }
+
+	// Returns a symbol fall, indexed from a step's first fall.
+	FORCEINLINE const FSymbolFall& GetFall(int32 index) const { return Falls[index]; }
+
+	// Returns the number of steps.
+	FORCEINLINE int32 GetNumberOfSteps() const { return Steps.Num(); }
+
+	// Returns a removed cell, indexed from a step's first removed cell.
+	FORCEINLINE const FRowColumn& GetRemoved(int32 index) const { return Removed[index]; }
+
+	// Returns a step, in the order they happened.
+	FORCEINLINE const FColumnsCascadeStep& GetStep(int32 index) const { return Steps[index]; }
+
+	// Returns the cells removed by every step together, the jewels collected.
+	FORCEINLINE int32 GetTotalRemoved() const { return Removed.Num(); }
+
+protected:
+
+	// The number of removal steps.
+	int32 Depth = 0;
+
+	// The symbol falls of every step, one after the other.
+	TArray<FSymbolFall> Falls;
+
+	// The cells removed by every step, one after the other.
+	TArray<FRowColumn> Removed;
+
+	// The steps of the cascade.
+	TArray<FColumnsCascadeStep> Steps;
+
+	// The falls and removed cells of the step being resolved, before they're appended.
+	TArray<FSymbolFall> StepFalls;
+	TArray<FRowColumn> StepRemoved;
+};
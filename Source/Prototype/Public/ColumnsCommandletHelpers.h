@@ -0,0 +1,23 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColumnsGame.h"
+
+// Helpers shared by the commandlets that play headless games.
+struct PROTOTYPE_API FColumnsCommandletHelpers
+{
+	// Append rows to a CSV file, writing the header first if the file is new, so runs with different rules
+	// end up in one file; logs and returns false if it can't be written.
+	static bool AppendCsv(const FString& path, const FString& header, const FString& rows);
+
+	// Returns the CSV column names of the game rules, without a leading or trailing comma.
+	static FString GetSettingsCsvHeader();
+
+	// Returns the game rules as CSV values, in the order of the header.
+	static FString GetSettingsCsvValues(const FColumnsGameSettings& settings);
+
+	// Parse the game rule options (-columns= -rows= -symbols= -startlevel= -jewelsrequired= -filledbase=
+	// -filledperlevel= -gravity= -gravityscale= -endless=) into the settings, keeping values not given.
+	static void ParseSettings(const FString& params, FColumnsGameSettings& outSettings);
+};
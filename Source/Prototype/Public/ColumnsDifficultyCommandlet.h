@@ -0,0 +1,30 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ColumnsDifficultyCommandlet.generated.h"
+
+// Estimates how hard each level is by playing many headless games of it on every core with a reference
+// policy. Every game starts at the level and ends once it's cleared, lost or runs out of pieces, and a row
+// per level is appended to a CSV file: the share of games cleared, lost and still going when the pieces ran
+// out (which survived without clearing), the pieces it takes to clear, and how deep the cascades of its
+// landings go. Every level is played on the same seeds, so levels differ only by their rules.
+//
+// UE4Editor-Cmd Prototype -run=ColumnsDifficulty -nullrhi -games=2000 -firstlevel=1 -lastlevel=10
+//
+// Options: -games= (per level) -seed= -policy=random|greedy|search -maxpieces= (per level) -inputinterval=
+// (0 or -instant drops each trinity straight in) -firstlevel= -lastlevel= -jewelsrequired= -gravity=
+// -gravityscale= -filledbase= -filledperlevel= -columns= -rows= -symbols= -endless= -output=
+UCLASS()
+class PROTOTYPE_API UColumnsDifficultyCommandlet : public UCommandlet
+{
+
+	GENERATED_BODY()
+
+public:
+
+	UColumnsDifficultyCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
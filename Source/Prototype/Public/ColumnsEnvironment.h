@@ -0,0 +1,160 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BoardBatchKernel.h"
+#include "ColumnsGame.h"
+#include "ColumnsPolicy.h"
+
+class FColumnsEnvironmentWorker;
+
+// The shape of a vectorized environment.
+struct FColumnsEnvironmentSettings
+{
+	// The rules every game is played with.
+	FColumnsGameSettings Game;
+
+	// The number of games stepped together.
+	int32 NumberOfGames = 64;
+
+	// Threads that step games alongside the caller; 0 steps every game on the calling thread.
+	int32 NumberOfThreads = 0;
+
+	// Pieces after which a game is cut short and reported done; 0 to play every game until it's over.
+	int32 MaxPieces = 0;
+
+	// Whether to resolve the cascades of BOARD_BATCH_LANES games at a time on a board batch, with the best
+	// kernel the CPU can run, when the board fits in one; otherwise each game resolves its own.
+	bool bBatchCascades = true;
+};
+
+// Many independent headless games behind a reset and step interface, for training placement agents
+// offline. An action is a placement of the falling trinity, column * PAWN_SIZE + shuffle downs, and each
+// step plays one in every game at once, split across the environment's own threads. Each thread resolves the
+// cascades of its games BOARD_BATCH_LANES at a time on its own board batch. Every buffer is sized by init
+// and written in place, so stepping never allocates, on the calling thread or the environment's.
+//
+// Each game's observation is GetObservationSize() bytes at game * GetObservationSize(): the cells in
+// row-major order, then the falling trinity top first, then the next trinity, each 0 for empty or the
+// symbol index + 1. Its action mask is GetNumberOfActions() bytes, 1 where the column can be reached.
+class PROTOTYPE_API FColumnsEnvironment
+{
+
+public:
+
+	// Returns the placement an action stands for.
+	static FColumnsPlacement ActionToPlacement(int32 action);
+
+	// Returns the action that stands for a placement.
+	static int32 PlacementToAction(const FColumnsPlacement& placement);
+
+	FColumnsEnvironment() = default;
+
+	// The threads step the environment they were started by, so it can't be copied.
+	FColumnsEnvironment(const FColumnsEnvironment&) = delete;
+	FColumnsEnvironment& operator=(const FColumnsEnvironment&) = delete;
+
+	~FColumnsEnvironment();
+
+	// Size the games and buffers and start the threads; the only call that allocates. Call once.
+	void Init(const FColumnsEnvironmentSettings& inSettings);
+
+	// Start every game again, game i on seed + i, and write their observations.
+	void Reset(int32 seed);
+
+	// Play actions[i] in game i for every game, and write the rewards, done flags and observations. A game
+	// that ends is started again on its next seed before its observation is written, so every observation
+	// is of a live game. An action the mask rules out drops the trinity where it spawned.
+	void Step(const int32* actions);
+
+	// Returns the action masks of every game, one after the other.
+	FORCEINLINE const uint8* GetActionMasks() const { return ActionMasks.GetData(); }
+
+	// Returns a flag per game, 1 if the last step ended its game.
+	FORCEINLINE const uint8* GetDones() const { return Dones.GetData(); }
+
+	// Returns a score per game, the final score of the game the last step ended where it's done.
+	FORCEINLINE const int32* GetEpisodeScores() const { return EpisodeScores.GetData(); }
+
+	// Returns a game, to inspect its board, score and level.
+	FORCEINLINE const FColumnsGame& GetGame(int32 index) const { return Games[index]; }
+
+	FORCEINLINE int32 GetNumberOfActions() const { return NumberOfActions; }
+
+	FORCEINLINE int32 GetNumberOfGames() const { return Settings.NumberOfGames; }
+
+	// Returns the number of threads stepping games alongside the caller.
+	FORCEINLINE int32 GetNumberOfWorkers() const { return Workers.Num(); }
+
+	// Returns the observations of every game, one after the other.
+	FORCEINLINE const uint8* GetObservations() const { return Observations.GetData(); }
+
+	FORCEINLINE int32 GetObservationSize() const { return ObservationSize; }
+
+	// Returns a reward per game, the score the last step gained.
+	FORCEINLINE const float* GetRewards() const { return Rewards.GetData(); }
+
+	// Returns the id of a thread stepping games alongside the caller, to count its allocations too.
+	uint32 GetWorkerThreadId(int32 index) const;
+
+	// Returns true if the games' cascades are resolved on board batches.
+	FORCEINLINE bool IsBatchingCascades() const { return Batches.Num() > 0; }
+
+protected:
+
+	friend class FColumnsEnvironmentWorker;
+
+	// Write a game's reward and done flag for the step, and start it again if it's done.
+	void FinishStep(int32 index, int32 scoreBefore);
+
+	// Resolve the cascades of the games placed in a slice's batch and finish their steps.
+	void ResolveBatch(int32 slice, const int32* laneGames, const int32* laneScoresBefore, int32 numberOfLanes);
+
+	// Step the games of a slice with the pending actions.
+	void StepSlice(int32 slice);
+
+	// Write a game's observation and action mask.
+	void WriteObservation(int32 index);
+
+	// One action mask per game.
+	TArray<uint8> ActionMasks;
+
+	// A board batch per slice to resolve its games' cascades on; empty if they're resolved one at a time.
+	TArray<FBoardBatch> Batches;
+
+	// One done flag per game.
+	TArray<uint8> Dones;
+
+	// One final score per game, set where it's done.
+	TArray<int32> EpisodeScores;
+
+	// The games.
+	TArray<FColumnsGame> Games;
+
+	// The number of games in each slice; the caller steps the first slice and each thread one of the rest.
+	int32 GamesPerSlice = 0;
+
+	// The seed each game is started on when it next ends.
+	TArray<int32> NextSeeds;
+
+	// The number of actions, a placement for each column and shuffle.
+	int32 NumberOfActions = 0;
+
+	// The bytes of one game's observation.
+	int32 ObservationSize = 0;
+
+	// One observation per game.
+	TArray<uint8> Observations;
+
+	// The actions of the step being played; only set during step.
+	const int32* PendingActions = nullptr;
+
+	// One reward per game.
+	TArray<float> Rewards;
+
+	// The settings the environment was made with.
+	FColumnsEnvironmentSettings Settings;
+
+	// The threads stepping the slices after the first; owned by the environment.
+	TArray<FColumnsEnvironmentWorker*> Workers;
+};
@@ -0,0 +1,328 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColumnsBoard.h"
+#include "ColumnsCascade.h"
+#include "ColumnsSnapshot.h"
+
+class FBoardBatch;
+
+// Set the number of symbols in the pawn.
+constexpr int32 PAWN_SIZE = 3;
+
+// Sets the pawn speed when transitioning between locations.
+constexpr int32 PAWN_SPEED_PIXELS_PER_SECOND = 1200;
+
+// Sets the pixels per second that gravity pulls down the symbol (adjusted by level)
+constexpr int32 PAWN_GRAVITY_PIXELS_PER_SECOND = 90;
+
+// how many pixels per second to add to gravity per level
+constexpr float PAWN_GRAVITY_LEVEL_SCALE = 20;
+
+// The rows an endless board scrolls by at a time.
+constexpr int32 ENDLESS_CHUNK_ROWS = 4;
+
+// The rows an endless board keeps empty at the top for the trinity to enter.
+constexpr int32 ENDLESS_EMPTY_ROWS = 6;
+
+// The inputs that can be given to the falling trinity, matching the pawn's input bindings.
+enum class EColumnsInput : uint8
+{
+	MOVE_LEFT,
+	MOVE_RIGHT,
+	SHUFFLE_UP,
+	SHUFFLE_DOWN,
+	MOVE_DOWN_PRESSED,
+	MOVE_DOWN_RELEASED,
+};
+
+// The tunable rules of a game; defaults match the game as played through the actors.
+struct FColumnsGameSettings
+{
+	int32 NumberOfColumns = GAME_BOARD_NUMBER_OF_COLUMNS;
+	int32 NumberOfRows = GAME_BOARD_NUMBER_OF_ROWS;
+	int32 NumberOfSymbols = GAME_BOARD_NUMBER_OF_SYMBOLS;
+
+	// The level the game starts at.
+	int32 StartLevel = 1;
+
+	// The number of jewels to collect to advance a level.
+	int32 JewelsRequired = 20;
+
+	// Rows of random symbols at the start of a level are FilledRowsBase + level * FilledRowsPerLevel.
+	int32 FilledRowsBase = 1;
+	int32 FilledRowsPerLevel = 1;
+
+	// Gravity is GravityPixelsPerSecond + level * GravityLevelScale.
+	float GravityPixelsPerSecond = PAWN_GRAVITY_PIXELS_PER_SECOND;
+	float GravityLevelScale = PAWN_GRAVITY_LEVEL_SCALE;
+
+	// The height in rows of an endless board, that the window of NumberOfRows rows scrolls down as the
+	// symbols are cleared; 0 for the game of levels, where each level starts a new board.
+	int32 EndlessRows = 0;
+
+	// The rows an endless board scrolls by at a time, and the rows it keeps empty at the top.
+	int32 EndlessChunkRows = ENDLESS_CHUNK_ROWS;
+	int32 EndlessEmptyRows = ENDLESS_EMPTY_ROWS;
+
+	// Returns the gravity used to pull down the trinity at a level.
+	FORCEINLINE float GetGravityPixelsPerSecond(int32 level) const { return GravityPixelsPerSecond + level * GravityLevelScale; }
+
+	// Returns the first row of random symbols when constructing the board for a level; an endless board is
+	// filled all the way up to the rows kept empty.
+	FORCEINLINE int32 GetRowToStartRandomSymbols(int32 level) const
+	{
+		if (IsEndless()) return FMath::Clamp(EndlessEmptyRows, 0, NumberOfRows);
+
+		return FColumnsBoard::GetRowToStartRandomSymbols(NumberOfRows, FilledRowsBase + level * FilledRowsPerLevel);
+	}
+
+	// Returns true for an endless board, which scrolls instead of starting again at each level.
+	FORCEINLINE bool IsEndless() const { return EndlessRows > 0; }
+
+	// Scroll an endless board once a cascade has settled; returns the number of rows retired.
+	FORCEINLINE int32 ScrollEndless(FColumnsBoard& board, FColumnsRandom& random) const
+	{
+		return IsEndless() ? board.ScrollEndless(EndlessEmptyRows, EndlessChunkRows, EndlessRows, random) : 0;
+	}
+};
+
+// A board filled ahead of time for a level, with what it was filled from.
+struct FColumnsNextBoard
+{
+	// The filled board.
+	FColumnsBoard Board;
+
+	// The board random numbers after filling it.
+	FColumnsRandom Random;
+
+	// The first row of random symbols it was filled from.
+	int32 RowToStartRandomSymbols = 0;
+
+	// The board random numbers it was filled from.
+	FColumnsRandom StartRandom;
+
+	// Fill the board; it only touches this copy, so it can run on any thread.
+	FORCEINLINE void Fill() { Board.Construct(RowToStartRandomSymbols, Random); }
+};
+
+// A complete game of columns with no dependency on actors, components or the world: the board, the
+// falling trinity, levels and score. Time only moves when advance is called, so a game can be played
+// headless as fast as the rules can be evaluated, on any thread.
+class PROTOTYPE_API FColumnsGame
+{
+
+public:
+
+	// Returns the score for collecting a number of jewels in one go.
+	static int32 ScoreForJewels(int32 jewels);
+
+	// Move the trinity down under gravity (or quickly if move down is held) and land it if it's blocked.
+	void Advance(float deltaSeconds);
+
+	// Advance by a whole number of milliseconds; the same total lands the same way however it's split up.
+	void AdvanceMs(int32 deltaMs);
+
+	// Apply an input to the falling trinity; returns false if the trinity couldn't move and nothing changed.
+	bool ApplyInput(EColumnsInput input);
+
+	// Returns true if the trinity can slide across to a column at its current rows, as drop piece needs.
+	bool CanReachColumn(int32 column) const;
+
+	// Pack the game into a snapshot; false if the board is too big for one.
+	bool CaptureSnapshot(FColumnsSnapshot& outSnapshot) const;
+
+	// Shuffle the trinity, move it to the column and drop it straight down; false if the column can't be reached.
+	bool DropPiece(int32 column, int32 shuffleDowns);
+
+	// Finish landing the trinity set on the board by place piece, from a lane of a batch that has resolved its
+	// cascade: take the settled board, add the cascade's jewels and score, then scroll, start the next level
+	// and spawn the next trinity as any landing does. The cascade's steps aren't kept.
+	void FinishPlacedPiece(const FBoardBatch& batch, int32 lane, int32 jewels, int32 score, int32 depth);
+
+	// Returns the row the top symbol lands in if the trinity drops straight down a column from its current rows.
+	int32 GetLandingRow(int32 column) const;
+
+	// Shuffle the trinity, move it to the column and set it on the board where it lands, as drop piece does,
+	// but leave the cascade for the caller to resolve along with other games' on a board batch, and then to
+	// finish the landing with finish placed piece; false if the column can't be reached. A trinity that
+	// lands above the top of the board ends the game there.
+	bool PlacePiece(int32 column, int32 shuffleDowns);
+
+	// Set up the next level's board to be filled ahead of time, from a copy of the board random numbers, which
+	// aren't used again during a level; false for an endless board, which is never filled again.
+	bool PrepareNextBoard(FColumnsNextBoard& outNextBoard) const;
+
+	// Start a new game; the seed decides the board and every trinity.
+	void Reset(const FColumnsGameSettings& inSettings, int32 seed);
+
+	// Carry on from a snapshot of a game reset with the same settings; false if it was taken on another size of board.
+	bool RestoreSnapshot(const FColumnsSnapshot& snapshot);
+
+	// Lend a board filled ahead of time for the next level, or nullptr to take it back; the caller keeps it until
+	// the level starts. The level only starts on it, moving it out, if filling one then would give the same
+	// board, so games come out the same whether it's used or not. Copies of the game don't take it.
+	void SetNextBoard(FColumnsNextBoard* nextBoard);
+
+	// Replace the board and put the trinity at a location, to carry on from a game played elsewhere.
+	void SetPosition(const FColumnsBoard& inBoard, int32 locationX, int32 locationY);
+
+	// Replace the symbol indicies of the falling and next trinities.
+	void SetTrinities(const TArray<int32>& currentSymbolIndicies, const TArray<int32>& nextSymbolIndicies);
+
+	FORCEINLINE const FColumnsBoard& GetBoard() const { return Board; }
+
+	// Returns the cascade of the last trinity to land, with every step it took.
+	FORCEINLINE const FColumnsCascade& GetLastCascade() const { return Cascade; }
+
+	FORCEINLINE const TArray<int32>& GetCurrentSymbolIndicies() const { return CurrentSymbolIndicies; }
+
+	// Returns how far the trinity has fallen below its location, in pixel milliseconds.
+	FORCEINLINE int64 GetFallProgress() const { return FallProgress; }
+
+	// Returns the zobrist hash of the board, level and jewels, and optionally the falling and next trinities;
+	// the trinity location isn't included.
+	uint64 GetHash(bool bWithTrinities = true) const;
+
+	FORCEINLINE int32 GetJewels() const { return Jewels; }
+
+	FORCEINLINE int32 GetLastCascadeDepth() const { return LastCascadeDepth; }
+
+	FORCEINLINE int32 GetLastLandedColumn() const { return LastLandedColumn; }
+
+	FORCEINLINE int32 GetLastLandedMs() const { return LastLandedMs; }
+
+	FORCEINLINE int32 GetLastLandedRow() const { return LastLandedRow; }
+
+	FORCEINLINE int32 GetLevel() const { return Level; }
+
+	FORCEINLINE int32 GetLocationX() const { return LocationX; }
+
+	FORCEINLINE int32 GetLocationY() const { return LocationY; }
+
+	FORCEINLINE int32 GetMaxCascadeDepth() const { return MaxCascadeDepth; }
+
+	FORCEINLINE const TArray<int32>& GetNextSymbolIndicies() const { return NextSymbolIndicies; }
+
+	FORCEINLINE int32 GetPiecesPlaced() const { return PiecesPlaced; }
+
+	FORCEINLINE int32 GetPieceMs() const { return PieceMs; }
+
+	FORCEINLINE int32 GetScore() const { return Score; }
+
+	FORCEINLINE const FColumnsGameSettings& GetSettings() const { return Settings; }
+
+	FORCEINLINE int32 GetTotalJewels() const { return TotalJewels; }
+
+	// Returns true if the last landing scrolled an endless board or filled the next level's board, rather
+	// than leaving the board as its cascade settled it.
+	FORCEINLINE bool HasBoardMovedOn() const { return bBoardMovedOn; }
+
+	FORCEINLINE bool IsGameOver() const { return bGameOver; }
+
+	FORCEINLINE bool IsMoveDownHeld() const { return MoveDownHeld; }
+
+protected:
+
+	// Returns true if the trinity would fit in the column at its current rows.
+	bool IsColumnFree(int32 column) const;
+
+	// Returns true if the trinity can't move down another row.
+	bool IsTrinityBlocked() const;
+
+	// Finish a landing whose cascade has been resolved: scroll, start the next level and spawn the next trinity.
+	void FinishLanding(int32 cascadeDepth);
+
+	// Add the trinity to the board, resolve the cascade and set up the next trinity or level.
+	void LandTrinity();
+
+	// Add the trinity to the board where it is; false if it's above the top of the board, which ends the game.
+	bool PlaceTrinity();
+
+	// Remove matches and collapse until the board settles; returns the number of removal steps.
+	int32 ResolveCascade();
+
+	// Make the next trinity the current one at the top of the board, and pick a new next trinity.
+	void SpawnTrinity();
+
+	// Construct the board and set the gravity for the current level.
+	void StartLevel();
+
+	// The board the trinity lands on.
+	FColumnsBoard Board;
+
+	// The cascade of the last trinity to land, resolved in one go.
+	FColumnsCascade Cascade;
+
+	// Symbol indicies that make up the falling trinity, top first.
+	TArray<int32> CurrentSymbolIndicies;
+
+	// Symbol indicies that make up the next trinity.
+	TArray<int32> NextSymbolIndicies;
+
+	// How far the trinity has fallen below its location, in pixel milliseconds; a row is GAME_BOARD_SPACING * 1000.
+	int64 FallProgress = 0;
+
+	// Set when a trinity lands above the top of the board.
+	bool bGameOver = false;
+
+	// Set when the last landing scrolled an endless board or filled the next level's board.
+	bool bBoardMovedOn = false;
+
+	// The gravity for the current level, rounded to whole pixels so the fall can be stepped exactly.
+	int32 GravityPixelsPerSecond = PAWN_GRAVITY_PIXELS_PER_SECOND;
+
+	// The number of collected jewels in the current level.
+	int32 Jewels = 0;
+
+	// The most removal steps in one cascade, and in the last one.
+	int32 LastCascadeDepth = 0;
+	int32 MaxCascadeDepth = 0;
+
+	// Where the last trinity landed, and how long it fell for; a negative row ended the game.
+	int32 LastLandedColumn = 0;
+	int32 LastLandedRow = 0;
+	int32 LastLandedMs = 0;
+
+	// The current level.
+	int32 Level = 1;
+
+	// Column index where the top symbol is located.
+	int32 LocationX = 0;
+
+	// Row index where the top symbol is located.
+	int32 LocationY = -PAWN_SIZE;
+
+	// Whether the trinity is being moved down quickly.
+	bool MoveDownHeld = false;
+
+	// The next level's board lent by the caller, if one has been filled ahead of time.
+	FColumnsNextBoard* NextBoard = nullptr;
+
+	// The game the next board was lent to; a copy of the game, for a search or a trial, is somewhere else and
+	// fills its own board instead.
+	const FColumnsGame* NextBoardGame = nullptr;
+
+	// The number of trinities landed on the board.
+	int32 PiecesPlaced = 0;
+
+	// Time passed to advance that hasn't made up a whole millisecond yet.
+	float PendingSeconds = 0.0f;
+
+	// Milliseconds the current trinity has been falling for; the clock replays are timed against.
+	int32 PieceMs = 0;
+
+	// Random numbers for filling the board and for the trinities; seeded by reset.
+	FColumnsRandom BoardRandom;
+	FColumnsRandom PieceRandom;
+
+	// The total score.
+	int32 Score = 0;
+
+	// The rules the game was reset with.
+	FColumnsGameSettings Settings;
+
+	// Jewels collected over all levels.
+	int32 TotalJewels = 0;
+};
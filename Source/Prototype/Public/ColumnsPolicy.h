@@ -0,0 +1,44 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColumnsGame.h"
+#include "ColumnsRandom.h"
+
+// A placement of the falling trinity: the column it drops into and how many times it's shuffled down first.
+struct FColumnsPlacement
+{
+	int32 Column = 0;
+	int32 ShuffleDowns = 0;
+};
+
+// Scripted ways of choosing where the trinity goes.
+enum class EColumnsPolicy : uint8
+{
+	// Any column and shuffle, picked at random.
+	RANDOM,
+
+	// The placement that collects the most jewels now, keeping the stack low on ties; the placements'
+	// cascades are resolved together on a batch of boards when the board fits in one.
+	GREEDY,
+
+	// The move search, looking at the next trinity too; no time budget, so games are repeatable.
+	SEARCH,
+};
+
+// Scripted players for headless games.
+struct PROTOTYPE_API FColumnsPolicy
+{
+	// Choose a placement for the current trinity of the game.
+	static FColumnsPlacement ChoosePlacement(EColumnsPolicy policy, const FColumnsGame& game, FColumnsRandom& random);
+
+	// Returns the number of rows between the bottom of the board and the highest symbol.
+	static int32 GetStackHeight(const FColumnsBoard& board);
+
+	// Parse a policy name (random, greedy, search); returns false if not recognised.
+	static bool Parse(const FString& name, EColumnsPolicy& outPolicy);
+
+	// Play the game until it's over or maxPieces have landed. Inputs are given one per input interval
+	// while the trinity falls, like a player pressing keys; an interval of 0 drops each trinity straight in.
+	static void PlayGame(FColumnsGame& game, EColumnsPolicy policy, FColumnsRandom& random, float inputIntervalSeconds, int32 maxPieces);
+};
@@ -0,0 +1,68 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Stream of the per-game generator that fills the board.
+constexpr uint64 COLUMNS_RANDOM_STREAM_BOARD = 1;
+
+// Stream of the per-game generator that picks the trinities. Separate from the board stream so the
+// order the board and pawn begin play in doesn't change either sequence.
+constexpr uint64 COLUMNS_RANDOM_STREAM_PIECES = 2;
+
+// Stream of the seeds for the searches the pawn runs for each trinity, drawn from the game's seed and the
+// pieces placed so a game played again searches the same way.
+constexpr uint64 COLUMNS_RANDOM_STREAM_SEARCH = 3;
+
+// A small seeded random number generator (PCG32) with no global state, so every game can own one,
+// reproduce its sequence from the seed, and run on any thread.
+struct FColumnsRandom
+{
+	uint64 State = 0x853c49e6748fea9bull;
+	uint64 Increment = 0xda3e39cb94b95bdbull;
+
+	FORCEINLINE FColumnsRandom() {}
+	FORCEINLINE FColumnsRandom(uint64 seed, uint64 stream = 0) { Initialize(seed, stream); }
+
+	// Start the sequence for a seed; different streams of the same seed are independent sequences.
+	FORCEINLINE void Initialize(uint64 seed, uint64 stream = 0)
+	{
+		State = 0;
+		Increment = (stream << 1) | 1;
+		Next();
+		State += seed;
+		Next();
+	}
+
+	// Returns true if both generators will produce the same sequence from here on.
+	FORCEINLINE bool operator==(const FColumnsRandom& other) const
+	{
+		return State == other.State && Increment == other.Increment;
+	}
+
+	// Returns the next 32 random bits.
+	FORCEINLINE uint32 Next()
+	{
+		const uint64 oldState = State;
+		State = oldState * 6364136223846793005ull + Increment;
+
+		const uint32 xorShifted = (uint32)(((oldState >> 18) ^ oldState) >> 27);
+		const uint32 rotation = (uint32)(oldState >> 59);
+		return (xorShifted >> rotation) | (xorShifted << ((0u - rotation) & 31));
+	}
+
+	// Returns a random integer from min to max inclusive, without modulo bias.
+	FORCEINLINE int32 RandRange(int32 min, int32 max)
+	{
+		const uint32 range = (uint32)(max - min) + 1;
+		if (range == 0) return (int32)Next();
+
+		// reject the few values at the bottom that would make some results more likely
+		const uint32 threshold = (0u - range) % range;
+		while (true)
+		{
+			const uint32 value = Next();
+			if (value >= threshold) return min + (int32)(value % range);
+		}
+	}
+};
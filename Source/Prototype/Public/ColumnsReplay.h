@@ -0,0 +1,79 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColumnsGame.h"
+
+// Identifies a replay file ("CLRP").
+constexpr uint32 COLUMNS_REPLAY_MAGIC = 0x50524C43;
+
+// Bump when the replay layout or the rules it plays back with change; other versions aren't read.
+constexpr uint16 COLUMNS_REPLAY_VERSION = 3;
+
+// Replay event type for a trinity landing; every other type is an EColumnsInput.
+constexpr uint8 COLUMNS_REPLAY_LANDED = 0xFF;
+
+// One recorded event. Times restart at 0 for every trinity, and only count while it's falling, so the
+// time spent animating cascades doesn't matter when the replay is played back on a headless game.
+struct FColumnsReplayEvent
+{
+	// An EColumnsInput, or COLUMNS_REPLAY_LANDED.
+	uint8 Type = 0;
+
+	// Milliseconds since the trinity spawned.
+	uint32 TimeMs = 0;
+
+	// Where the trinity landed, for landed events.
+	int8 Column = 0;
+	int8 Row = 0;
+};
+
+// A recorded game: the seed and rules it started with, plus the stream of inputs and landings.
+// Saved as a small binary file; the events are packed as a type byte and a variable length time delta.
+class PROTOTYPE_API FColumnsReplay
+{
+
+public:
+
+	// Start a new recording, clearing any events.
+	void Begin(int32 inSeed, const FColumnsGameSettings& inSettings);
+
+	// Load a replay saved by save to file; false if the file is missing or not a replay.
+	bool LoadFromFile(const FString& filename);
+
+	// Re-run the replay on a headless game as fast as the rules can be evaluated. Returns false, with
+	// a description, at the first input or landing that doesn't match the recording.
+	bool Play(FColumnsGame& game, FString& outError) const;
+
+	// Record an input given pieceMs after the current trinity spawned.
+	void RecordInput(EColumnsInput input, int32 pieceMs);
+
+	// Record the current trinity landing; a negative row ended the game.
+	void RecordLanded(int32 pieceMs, int32 column, int32 row);
+
+	// Drop the events recorded after the first numberOfEvents, for a game stepped back to then.
+	void RewindEvents(int32 numberOfEvents);
+
+	// Save the replay as a binary file.
+	bool SaveToFile(const FString& filename);
+
+	// Read or write the replay.
+	void Serialize(FArchive& archive);
+
+	FORCEINLINE const TArray<FColumnsReplayEvent>& GetEvents() const { return Events; }
+
+	FORCEINLINE int32 GetSeed() const { return Seed; }
+
+	FORCEINLINE const FColumnsGameSettings& GetSettings() const { return Settings; }
+
+protected:
+
+	// The recorded inputs and landings, in order.
+	TArray<FColumnsReplayEvent> Events;
+
+	// The seed of the game's random numbers.
+	int32 Seed = 0;
+
+	// The rules the game was played with.
+	FColumnsGameSettings Settings;
+};
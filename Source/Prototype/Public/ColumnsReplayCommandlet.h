@@ -0,0 +1,26 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ColumnsReplayCommandlet.generated.h"
+
+// Re-runs saved replays on headless games and checks every trinity lands where it was recorded, to
+// catch changes to the rules that would break determinism. Returns 1 if any replay doesn't match.
+//
+// UE4Editor-Cmd Prototype -run=ColumnsReplay -nullrhi -replay=Saved/Replays
+//
+// Options: -replay= (a .replay file, or a directory of them; defaults to Saved/Replays) -repeat= (play
+// each replay this many times, for timing)
+UCLASS()
+class PROTOTYPE_API UColumnsReplayCommandlet : public UCommandlet
+{
+
+	GENERATED_BODY()
+
+public:
+
+	UColumnsReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,95 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColumnsGame.h"
+#include "ColumnsPolicy.h"
+#include "ColumnsTranspositionTable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+
+// How the move search looks ahead.
+struct FColumnsSearchSettings
+{
+	// Pieces to look ahead, counting the falling trinity. Only the falling and next trinities are
+	// known; pieces past those are averaged over a few random trinities.
+	int32 MaxDepth = 3;
+
+	// Random trinities tried for each piece past the next trinity.
+	int32 Samples = 3;
+
+	// Seconds the search may take; the deepest look ahead finished in time is used. 0 for no limit.
+	double BudgetSeconds = 0.05;
+
+	// Spread the placements of the falling trinity over the worker threads.
+	bool bParallel = true;
+
+	// Set from another thread to stop the search as if its budget ran out; nullptr if it can't be cancelled.
+	const FThreadSafeBool* Cancel = nullptr;
+};
+
+// The placement chosen by a search and how it was found.
+struct FColumnsSearchResult
+{
+	// Where to put the falling trinity.
+	FColumnsPlacement Placement;
+
+	// The look ahead that chose the placement, in pieces.
+	int32 Depth = 0;
+
+	// The number of placements tried, over all depths.
+	int32 Nodes = 0;
+
+	// The number of positions whose value was found in the transposition table.
+	int32 TableHits = 0;
+
+	// The value of the chosen placement.
+	int32 Value = 0;
+};
+
+// Looks ahead over every placement of the falling trinity and the pieces after it, resolving the
+// full cascade of each, and picks the placement that leads to the best board. The placements of
+// the falling trinity are searched in parallel, one look ahead depth at a time until the budget runs out.
+//
+// The value of every position depends only on the position, the depth and the seed, whichever thread
+// works it out first, so the table only saves time: with no budget and no cancel, the same game and seed
+// always give the same result. A budget or a cancel makes the depth reached depend on the machine.
+class PROTOTYPE_API FColumnsSearch
+{
+
+public:
+
+	// The table is optional; when given, it's shared by every thread and keeps its values between searches,
+	// which are only found again by searches with the same seed.
+	FColumnsSearch(const FColumnsSearchSettings& inSettings, FColumnsTranspositionTable* inTable = nullptr);
+
+	// Returns the value of a game after some placements, compared to the game before them.
+	static int32 Evaluate(const FColumnsGame& root, const FColumnsGame& game);
+
+	// Returns the value of the board of a game, ignoring what was collected to get there.
+	static int32 EvaluateBoard(const FColumnsGame& game);
+
+	// Returns the value of the jewels and score collected between two points of a game.
+	static int32 EvaluateGain(const FColumnsGame& from, const FColumnsGame& to);
+
+	// Returns the number of symbols stacked in a column.
+	static int32 GetColumnHeight(const FColumnsBoard& board, int32 column);
+
+	// Find the best placement of the game's falling trinity; seed decides the sampled pieces.
+	FColumnsSearchResult Search(const FColumnsGame& game, uint32 seed) const;
+
+protected:
+
+	// Returns the best value over every placement of the game's falling trinity, looking depth pieces
+	// ahead, counting only what's collected from this game on so the value can be cached. Pieces from
+	// depthIndex 2 on aren't known, so they're sampled from the seed and the position. Sets bOutOfTime and
+	// gives up once the deadline passes or the search is cancelled.
+	int32 SearchPiece(const FColumnsGame& game, int32 depthIndex, int32 depth, uint32 seed,
+		double deadlineSeconds, FThreadSafeBool& bOutOfTime, FThreadSafeCounter& nodes, FThreadSafeCounter& tableHits) const;
+
+	// How the search looks ahead.
+	FColumnsSearchSettings Settings;
+
+	// Values of positions already searched, if any.
+	FColumnsTranspositionTable* Table = nullptr;
+};
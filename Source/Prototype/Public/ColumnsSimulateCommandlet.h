@@ -0,0 +1,27 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ColumnsSimulateCommandlet.generated.h"
+
+// Plays batches of headless games against the board rules on every core, and appends aggregate
+// statistics to a CSV file for balancing runs. No actors, components or rendering are used.
+//
+// UE4Editor-Cmd Prototype -run=ColumnsSimulate -nullrhi -games=10000 -policy=greedy -jewelsrequired=20
+//
+// Options: -games= -seed= -policy=random|greedy|search -maxpieces= -inputinterval= (0 or -instant drops each
+// trinity straight in) -startlevel= -jewelsrequired= -gravity= -gravityscale= -filledbase= -filledperlevel=
+// -columns= -rows= -symbols= -endless= (rows of an endless board) -output=
+UCLASS()
+class PROTOTYPE_API UColumnsSimulateCommandlet : public UCommandlet
+{
+
+	GENERATED_BODY()
+
+public:
+
+	UColumnsSimulateCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,147 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColumnsBoard.h"
+
+struct FColumnsGameSettings;
+
+// The 64 bit words a snapshot packs the board cells into. A cell never straddles two words, so a word
+// holds 21 cells of 3 bits (up to 7 symbols) or 16 of 4 bits (up to 15 symbols); a 6x13 board takes 4.
+constexpr int32 COLUMNS_SNAPSHOT_CELL_WORDS = 24;
+
+// Identifies a save file ("CLSV").
+constexpr uint32 COLUMNS_SAVE_MAGIC = 0x56534C43;
+
+// Bump when the snapshot or settings layout changes; saves of any other version aren't resumed.
+constexpr uint32 COLUMNS_SAVE_VERSION = 1;
+
+// A game state packed into a fixed size: the board cells at 3 or 4 bits each, the falling and next
+// trinities, the random numbers, level and score. It holds no pointers or arrays, so copying one is a
+// memcpy, a ring of them never allocates, and one is written to a file and mapped back as it is.
+struct PROTOTYPE_API FColumnsSnapshot
+{
+
+	// Returns the bits each cell takes on a board with a number of symbols; 0 if there are too many.
+	static int32 GetBitsPerCell(int32 numberOfSymbols);
+
+	// Returns the falling (trinity 0) or next (trinity 1) symbol indicies.
+	void GetTrinity(int32 trinity, TArray<int32>& outSymbolIndicies) const;
+
+	// Returns true if the snapshot was taken on a board of the size the settings give.
+	bool MatchesSettings(const FColumnsGameSettings& settings) const;
+
+	// Pack the board's cells and scrolled rows; false if the board is too big for a snapshot.
+	bool PackBoard(const FColumnsBoard& board);
+
+	// Set the falling and next trinity symbol indicies; each symbol index is less than 15.
+	void SetTrinities(const TArray<int32>& currentSymbolIndicies, const TArray<int32>& nextSymbolIndicies);
+
+	// Replace the board with the packed one, keeping its hash and bitboard up to date.
+	void UnpackBoard(FColumnsBoard& board) const;
+
+	// The board cells in row-major order, BitsPerCell bits each.
+	uint64 Cells[COLUMNS_SNAPSHOT_CELL_WORDS] = {};
+
+	// Random numbers for filling the board and for the trinities.
+	FColumnsRandom BoardRandom;
+	FColumnsRandom PieceRandom;
+
+	// How far the trinity has fallen below its location, in pixel milliseconds.
+	int64 FallProgress = 0;
+
+	// The rows retired off the top of an endless board.
+	int32 FirstRow = 0;
+
+	// Time passed to advance that hasn't made up a whole millisecond yet.
+	float PendingSeconds = 0.0f;
+
+	// Milliseconds the falling trinity has been falling for.
+	int32 PieceMs = 0;
+
+	// The number of trinities landed on the board.
+	int32 PiecesPlaced = 0;
+
+	// The number of replay events recorded up to the snapshot, so a rewind can drop the ones after it.
+	int32 ReplayEvents = 0;
+
+	// The total score, and the jewels collected over all levels.
+	int32 Score = 0;
+	int32 TotalJewels = 0;
+
+	// The falling trinity top first, then the next trinity, 4 bits a symbol index from the low bits up.
+	uint32 Trinities = 0;
+
+	// The current level and the jewels collected in it.
+	int16 Level = 1;
+	int16 Jewels = 0;
+
+	// The most removal steps in one cascade, and in the last one.
+	int16 LastCascadeDepth = 0;
+	int16 MaxCascadeDepth = 0;
+
+	// The size of the board and the bits each cell is packed in.
+	uint16 NumberOfRows = 0;
+	uint8 NumberOfColumns = 0;
+	uint8 NumberOfSymbols = 0;
+	uint8 BitsPerCell = 0;
+
+	// Column and row index where the top symbol of the falling trinity is located.
+	int8 LocationX = 0;
+	int8 LocationY = 0;
+
+	// Set when a trinity landed above the top of the board.
+	bool bGameOver = false;
+
+	// Whether the trinity is being moved down quickly.
+	bool bMoveDownHeld = false;
+};
+
+// The last few snapshots of a game, oldest overwritten first, to step back through. The slots are
+// allocated once, and a snapshot is written straight into its slot.
+class PROTOTYPE_API FColumnsSnapshotRing
+{
+
+public:
+
+	// Size the ring to hold a number of snapshots and empty it.
+	void Init(int32 capacity);
+
+	// Returns the slot for a new snapshot, which becomes the newest; overwrites the oldest once full.
+	FColumnsSnapshot& Push();
+
+	// Returns the snapshot a number of steps back from the newest (0 is the newest) and drops every snapshot
+	// after it, or nullptr if the ring doesn't go back that far.
+	const FColumnsSnapshot* Rewind(int32 steps);
+
+	// Drop every snapshot.
+	void Reset();
+
+	FORCEINLINE int32 GetCapacity() const { return Slots.Num(); }
+
+	FORCEINLINE int32 GetNum() const { return Count; }
+
+protected:
+
+	// The number of snapshots held.
+	int32 Count = 0;
+
+	// The slot of the newest snapshot.
+	int32 Newest = INDEX_NONE;
+
+	// One snapshot per slot.
+	TArray<FColumnsSnapshot> Slots;
+};
+
+// A save file is a small header, the game settings and one snapshot, written as they are in memory, so
+// resuming maps the file and copies the snapshot out. Saves are only read back on the platform and build
+// that wrote them, which the header sizes check.
+struct PROTOTYPE_API FColumnsSaveFile
+{
+
+	// Load a save written by save; false if the file is missing, from another version, or the wrong size.
+	static bool Load(const FString& filename, int32& outSeed, FColumnsGameSettings& outSettings, FColumnsSnapshot& outSnapshot);
+
+	// Write a save file, replacing any file already there only once the whole save has been written.
+	static bool Save(const FString& filename, int32 seed, const FColumnsGameSettings& settings, const FColumnsSnapshot& snapshot);
+};
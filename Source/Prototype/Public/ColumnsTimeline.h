@@ -0,0 +1,69 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+
+// One cell's movement in a timeline: from one location to another, starting at a time and taking a duration.
+struct FColumnsTimelineTrack
+{
+	// The cell whose symbol moves.
+	int32 Cell = INDEX_NONE;
+
+	// Where the symbol starts.
+	FVector From = FVector::ZeroVector;
+
+	// Where the symbol ends.
+	FVector To = FVector::ZeroVector;
+
+	// Seconds into the timeline the movement starts.
+	float StartSeconds = 0.0f;
+
+	// Seconds the movement takes.
+	float DurationSeconds = 0.0f;
+};
+
+// A list of tracks played against its own clock. The owner advances the clock once a frame and then
+// reads every track's location in one pass, so several boards can animate independently of each other.
+class PROTOTYPE_API FColumnsTimeline
+{
+
+public:
+
+	// Add a track; the timeline lasts until the end of its longest track.
+	void AddTrack(int32 cell, const FVector& from, const FVector& to, float durationSeconds, float startSeconds = 0.0f);
+
+	// Move the clock forward; returns true once every track has finished.
+	bool Advance(float deltaSeconds);
+
+	// Returns the location of a track at the current time.
+	FVector GetLocation(int32 index) const;
+
+	// Returns the number of tracks.
+	FORCEINLINE int32 GetNumberOfTracks() const { return Tracks.Num(); }
+
+	// Returns the seconds since the timeline was reset.
+	FORCEINLINE float GetSeconds() const { return Seconds; }
+
+	// Returns a track.
+	FORCEINLINE const FColumnsTimelineTrack& GetTrack(int32 index) const { return Tracks[index]; }
+
+	// Returns true once the clock has passed the end of every track.
+	FORCEINLINE bool IsFinished() const { return Seconds >= DurationSeconds; }
+
+	// Remove the tracks and restart the clock; keeps the memory for the next animation.
+	void Reset();
+
+	// Make room for a number of tracks, so animations up to that size never allocate.
+	FORCEINLINE void Reserve(int32 numberOfTracks) { Tracks.Reserve(numberOfTracks); }
+
+protected:
+
+	// The seconds until the last track ends.
+	float DurationSeconds = 0.0f;
+
+	// The seconds since the timeline was reset.
+	float Seconds = 0.0f;
+
+	// The movements to play.
+	TArray<FColumnsTimelineTrack> Tracks;
+};
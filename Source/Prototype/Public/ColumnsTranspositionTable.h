@@ -0,0 +1,45 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Atomic.h"
+#include "Templates/UniquePtr.h"
+
+// A fixed size cache of values for game states, keyed by their zobrist hash, shared by every thread of
+// a search without locks. Each entry is two 64 bit words: the data, and the key xor the data. A reader
+// only accepts an entry if the key it rebuilds matches, so an entry torn by two threads writing at once
+// reads as a miss instead of a wrong value. New entries always replace old ones.
+class PROTOTYPE_API FColumnsTranspositionTable
+{
+
+public:
+
+	// Allocate 2^sizeLog2 entries of 16 bytes.
+	FColumnsTranspositionTable(int32 sizeLog2 = 16);
+
+	// Forget every entry.
+	void Clear();
+
+	// Look up the value stored for a key at a depth; false if there isn't one.
+	bool Probe(uint64 key, int32 depth, int32& outValue) const;
+
+	// Store a value for a key at a depth.
+	void Store(uint64 key, int32 depth, int32 value);
+
+	FORCEINLINE int32 GetNumberOfEntries() const { return (int32)(Mask + 1); }
+
+protected:
+
+	// One slot of the table.
+	struct FEntry
+	{
+		TAtomic<uint64> KeyXorData;
+		TAtomic<uint64> Data;
+	};
+
+	// The entries; a key's slot is its low bits.
+	TUniquePtr<FEntry[]> Entries;
+
+	// The number of entries minus one.
+	uint64 Mask = 0;
+};
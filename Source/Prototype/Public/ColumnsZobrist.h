@@ -0,0 +1,44 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Zobrist keys for hashing game states: every (cell, symbol), (trinity, position, symbol) and so on has
+// a fixed random 64 bit key, and a state's hash is the xor of the keys of everything in it, so a change
+// to one cell updates the hash with two xors. The keys are made by mixing the thing they stand for
+// rather than read from a table, so boards of any size can be hashed.
+struct FColumnsZobrist
+{
+	// Returns a well mixed 64 bit value for any input (splitmix64), the same every run.
+	static FORCEINLINE uint64 Mix(uint64 value)
+	{
+		value += 0x9e3779b97f4a7c15ull;
+		value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+		value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+		return value ^ (value >> 31);
+	}
+
+	// Returns the key for a symbol (>0, as stored on the board) in a cell; empty cells have no key.
+	static FORCEINLINE uint64 CellKey(int32 cellIndex, int32 symbol)
+	{
+		return symbol == 0 ? 0 : Mix((1ull << 56) | ((uint64)(uint32)cellIndex << 8) | (uint8)symbol);
+	}
+
+	// Returns the key for a symbol index at a position of the falling (trinity 0) or next (trinity 1) trinity.
+	static FORCEINLINE uint64 PieceKey(int32 trinity, int32 position, int32 symbolIndex)
+	{
+		return Mix((2ull << 56) | ((uint64)(uint8)trinity << 16) | ((uint64)(uint8)position << 8) | (uint8)symbolIndex);
+	}
+
+	// Returns the key for how far through the game a state is; level ups rebuild the board.
+	static FORCEINLINE uint64 ProgressKey(int32 level, int32 jewels)
+	{
+		return Mix((3ull << 56) | ((uint64)(uint32)level << 16) | (uint16)jewels);
+	}
+
+	// Returns a key to tell apart other uses of the same state, like the look ahead depth of a search.
+	static FORCEINLINE uint64 TagKey(int32 tag)
+	{
+		return Mix((4ull << 56) | (uint32)tag);
+	}
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+// a symbol moving down a column when empty spaces collapse, from one row to another
+struct FSymbolFall
+{
+	int32 Column;
+	int32 FromRow;
+	int32 ToRow;
+
+	FORCEINLINE FSymbolFall(int32 inColumn, int32 inFromRow, int32 inToRow) : Column(inColumn), FromRow(inFromRow), ToRow(inToRow) {}
+
+	FORCEINLINE bool operator==(const FSymbolFall &input) const
+	{
+		return Column == input.Column && FromRow == input.FromRow && ToRow == input.ToRow;
+	}
+};
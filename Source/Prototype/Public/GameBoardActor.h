@@ -2,22 +2,18 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "FRowColumn.h"
+#include "ColumnsGame.h"
+#include "ColumnsTimeline.h"
+#include "Components/InstancedStaticMeshComponent.h"
 #include "GameFramework/Actor.h"
 #include "GameBoardActor.generated.h"
 
-// Set the game board number of columns (width).
-constexpr int32 GAME_BOARD_NUMBER_OF_COLUMNS = 6;
-
-// Set the game board number of rows (length).
-constexpr int32 GAME_BOARD_NUMBER_OF_ROWS = 13;
-
-// Set the space of the grid and distance between elements.
-constexpr float GAME_BOARD_SPACING = 100.0f;
-
 // Amount of time that the highlight animation is played when removing symbols.
 constexpr float SYMBOL_HIGHLIGHT_SECONDS = 0.5f;
 
+// The slowest a cascade can be set to animate, so it always finishes.
+constexpr float CASCADE_MIN_ANIMATION_RATE = 0.1f;
+
 // Used for controlling tick animation state.
 UENUM(BlueprintType)
 enum class EAnimationState : uint8
@@ -27,22 +23,7 @@ enum class EAnimationState : uint8
 	EMPTY UMETA(DisplayName = "Empty"),
 };
 
-// Used to show which direction adjacent matching symbols are found.
-UENUM(BlueprintType)
-enum class EDirections : uint8
-{
-	INDETERMINATE UMETA(DisplayName = "Indeterminate"),
-	LEFT UMETA(DisplayName = "Left"),
-	DOWN_LEFT UMETA(DisplayName = "DownLeft"),
-	DOWN UMETA(DisplayName = "Down"),
-	DOWN_RIGHT UMETA(DisplayName = "DownRight"),
-	RIGHT UMETA(DisplayName = "Right"),
-	UP_RIGHT UMETA(DisplayName = "UpRight"),
-	UP UMETA(DisplayName = "Up"),
-	UP_LEFT UMETA(DisplayName = "UpLeft"),
-};
-
-// Holds the state of the game, and static mesh components that visually represent it.
+// Shows the game's board with static mesh components, playing back the cascade of each landing.
 UCLASS()
 class PROTOTYPE_API AGameBoardActor : public AActor
 {
@@ -53,55 +34,93 @@ public:
 	   
 	AGameBoardActor();
 
-	// Get the symbol located at the row and column.
-	int32 BoardGet(const int32 row, const int32 column) const;
+	// Show a trinity of symbols that just landed; the game's board already has them, and their cascade.
+	void BoardSetTrinity(const TArray<int32>& symbolsArray, int32 rowStart, int32 column);
 
-	// Set a trinity of symbols into the array and update the static mesh components.
-	void BoardSetTrinity(TArray<int32> symbolsArray, int32 rowStart, int32 column);
+	// Replace the symbol mesh instances with the game's board as it stands, keeping the components; after the
+	// game starts or is restored from a snapshot.
+	void ShowBoard();
 
-	// Trigger checks that remove adjacent symbols and collapse symbols into empty spaces below.
+	// Play back the steps of the cascade the game resolved as the trinity landed: removing adjacent symbols
+	// and collapsing symbols into empty spaces below, or all at once when fast forwarding.
 	void TriggerRemoveCollapseAnimate();
 
 	virtual void Tick(float DeltaTime) override;
 
 protected:
 	
-	// Start the symbol collapse animation; call after animating the match removal.
+	// Start the symbol collapse animation of the current cascade step; call after animating its match removal.
 	void AnimateCollapse();
 	
-	// Start the symbol removal animation; call after calling board remove matches at the end of a move.
+	// Start the symbol removal animation of the current cascade step, or finish the cascade once every step has played.
 	void AnimateRemoveMatches();
 
 	virtual void BeginPlay() override;
 
-	// Move symbols above empty spaces in the game board integer array down; return locations.
-	TArray<FRowColumn> BoardCollapseEmpty();
-
-	// Check if there are 3 or more of the same symbol adjacent to location and return direction.
-	EDirections BoardCheckForAdjacentThree(int32 row, int32 column);
-
-	// Generates the game board integer array - 0 empty, >0 symbol mesh indicies.
+	// Starts the game on a board of this size through the game mode, which owns it.
 	UFUNCTION(BlueprintCallable)
 	void BoardConstruct();
 
-	// Remove adjacent matching symbols of 3 or more, and return locations.
-	TArray<FRowColumn> BoardRemoveMatches();
+	// Apply every step of the cascade left to play to the symbol instances at once, then finish the cascade.
+	void FastForwardCascade();
+
+	// The cascade has settled and the instances show the board it settled: catch up with an endless board
+	// the game scrolled or the next level's board, and hand back to the pawn.
+	void FinishCascade();
+
+	// Add the jewels and score of a cascade step, as it's shown.
+	void ScoreCascadeStep(const FColumnsCascadeStep& step);
+
+	// Add an instance of a symbol mesh for a cell.
+	void SymbolInstanceAdd(int32 cellIndex, int32 staticMeshIndex);
+
+	// Move an instance of a symbol mesh, leaving its component to be marked dirty once every move is made.
+	void SymbolInstanceMove(int32 staticMeshIndex, int32 instance, const FTransform& transform);
 
-	// Set the symbol in the board integer array at the row and column.
-	void BoardSet(int32 row, int32 column, int32 symbol);
+	// Remove the symbol mesh instance of a cell, if it has one. The last instance of the mesh is moved into
+	// the gap, so no other instance changes index.
+	void SymbolInstanceRemove(int32 cellIndex);
 
-	// Construct the grid of static meshes that visually represent the game board symbols.
+	// Give the instances of the symbols that fell in a cascade step to the cells they fell to, optionally
+	// moving them there.
+	void SymbolInstancesFall(const FColumnsCascadeStep& step, bool bMoveInstances);
+
+	// Send the instances of the components that moved one since the last time to the renderer.
+	void SymbolInstancesMarkMovedDirty();
+
+	// Returns true if every cell shows the symbol on the game's board.
+	bool SymbolInstancesMatchBoard() const;
+
+	// Remove the highlighted instances of symbols being removed.
+	void SymbolRemovingInstancesClear();
+
+	// Returns the transform of a symbol mesh instance at row, column.
+	FTransform SymbolInstanceTransform(int32 row, int32 column) const;
+
+	// Construct the instanced static meshes that visually represent the game board symbols; one component
+	// per symbol mesh is created the first time, and after that only the instances are replaced.
 	UFUNCTION(BlueprintCallable)
 	void SymbolMeshComponentsConstruct();
 
-	// Replace the static mesh in the static mesh component at row, column.
+	// Replace the symbol mesh instance at row, column.
 	void SymbolMeshComponentsSet(int32 row, int32 column, int32 staticMeshIndex);
 	
 	// Stores the current state of animation for tick to look up.
 	EAnimationState AnimationState = EAnimationState::IDLE;
 
-	// The board value array, 0 for empty, and integer for symbol index.
-	TArray<int32> Board;
+	// How fast the cascade being played animates; 1 for normal speed.
+	float AnimationRate = 1.0f;
+
+	// The grid drawn behind the board, kept the board's size; the first grid in the level if not set.
+	UPROPERTY(EditAnywhere, Category = "GameBoard")
+	class AGridActor* GridActor = nullptr;
+
+	// The game whose board is shown, owned by the game mode; nullptr without one. Its last cascade is played
+	// back a step at a time, and isn't touched until the next trinity lands after it's played.
+	const FColumnsGame* Game = nullptr;
+
+	// The step of the cascade being animated.
+	int32 CascadeStep = 0;
 
 	// The number of columns in the game board.
 	int32 NumberOfColumns = GAME_BOARD_NUMBER_OF_COLUMNS;
@@ -120,12 +139,24 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "GameBoard")
 	TArray<UStaticMesh*> SymbolStaticMeshArray;
 
-	// Array of static mesh components show as the game state on the game board.
-	TArray<UStaticMeshComponent*> SymbolStaticMeshComponents;
+	// For each cell, the index of the symbol mesh shown, or INDEX_NONE if empty. Runs behind the game's board while animating.
+	TArray<int32> CellSymbols;
+
+	// For each cell, the index of its instance in the component of its symbol mesh, or INDEX_NONE if empty.
+	TArray<int32> CellInstances;
+
+	// For each symbol mesh, the cell of each of its instances.
+	TArray<TArray<int32>> InstanceCells;
+
+	// One instanced static mesh component per symbol mesh, showing the game state on the game board.
+	TArray<UInstancedStaticMeshComponent*> SymbolInstanceComponents;
+
+	// For each symbol instance component, whether one of its instances has moved since it was last marked dirty.
+	TArray<bool> SymbolInstanceComponentsMoved;
 
-	// A place to store symbols being removed during the match calculations.
-	TArray<FRowColumn> SymbolsToRemove;
+	// One instanced static mesh component per symbol mesh with the removing material, for symbols being removed.
+	TArray<UInstancedStaticMeshComponent*> SymbolRemovingInstanceComponents;
 
-	// A place to store symbols being collapsed (move downward).
-	TArray<FRowColumn> SymbolsToCollapse;
+	// The symbol movements being animated, with this board's animation clock.
+	FColumnsTimeline Timeline;
 };
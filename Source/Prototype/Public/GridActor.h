@@ -2,9 +2,12 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "ColumnsBoard.h"
+#include "Components/InstancedStaticMeshComponent.h"
 #include "GameFramework/Actor.h"
 #include "GridActor.generated.h"
 
+// The grid of points behind the game board, drawn as instances of one mesh. Never ticks.
 UCLASS()
 class PROTOTYPE_API AGridActor : public AActor
 {
@@ -15,20 +18,29 @@ public:
 	
 	AGridActor();
 	
-	// Construct the grid of static meshes for the play area.
+	// Construct the grid of static mesh instances for the play area; existing instances are moved rather than recreated.
 	void ConstructGrid();
 
-	virtual void Tick(float DeltaTime) override;
+	// Change the size of the play area and update the grid if it changed.
+	void SetDimensions(int32 numberOfColumns, int32 numberOfRows);
 
 protected:
 	
 	virtual void BeginPlay() override;
 
+	// One instance of the grid mesh per grid point.
+	UPROPERTY(VisibleAnywhere, Category = "Grid")
+	UInstancedStaticMeshComponent* GridInstances;
+
 	// Static mesh to use as the grid mesh.
 	UPROPERTY(EditAnywhere, Category = "Grid")
 	UStaticMesh* GridStaticMesh;
-	
-	// The array of static mesh components that make up the grid.
-	TArray<UStaticMeshComponent*> GridMeshComponents;
-	
+
+	// The number of columns of the play area; the grid has a point at every corner.
+	UPROPERTY(EditAnywhere, Category = "Grid")
+	int32 NumberOfColumns = GAME_BOARD_NUMBER_OF_COLUMNS;
+
+	// The number of rows of the play area.
+	UPROPERTY(EditAnywhere, Category = "Grid")
+	int32 NumberOfRows = GAME_BOARD_NUMBER_OF_ROWS;
 };
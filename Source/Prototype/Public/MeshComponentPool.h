@@ -0,0 +1,41 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/StaticMeshComponent.h"
+
+// Static mesh components owned by an actor that are handed out and taken back instead of being created
+// and destroyed, so showing a new set of meshes only reassigns meshes and transforms in place. Components
+// are only created when every one is in use, and are handed out in the same order every time.
+class PROTOTYPE_API FMeshComponentPool
+{
+
+public:
+
+	// Components are named namePrefix followed by a number.
+	FMeshComponentPool(const TCHAR* inNamePrefix);
+
+	// Returns a component showing the mesh at a location relative to the parent.
+	UStaticMeshComponent* Acquire(AActor* owner, USceneComponent* parent, UStaticMesh* staticMesh, const FVector& relativeLocation);
+
+	// Hide the components that weren't handed out again since the last release all.
+	void HideReleased();
+
+	// Take back every component handed out. They stay visible, so that handing them straight back out
+	// doesn't touch their render state; hide released hides the ones left over.
+	void ReleaseAll();
+
+	// Returns the number of components ever created by the pool.
+	FORCEINLINE int32 GetNumberOfComponents() const { return Components.Num(); }
+
+protected:
+
+	// Every component the pool has created; the first NumberInUse are handed out.
+	TArray<UStaticMeshComponent*> Components;
+
+	// Prefix of the component names.
+	FString NamePrefix;
+
+	// The number of components handed out.
+	int32 NumberInUse = 0;
+};
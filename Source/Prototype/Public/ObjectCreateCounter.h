@@ -0,0 +1,36 @@
+// Copyright 2019
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "UObject/UObjectArray.h"
+
+// Counts every UObject created, on any thread, while registered with the global object array.
+class PROTOTYPE_API FObjectCreateCounter : public FUObjectArray::FUObjectCreateListener
+{
+
+public:
+
+	virtual ~FObjectCreateCounter();
+
+	// Start counting.
+	void Register();
+
+	// Stop counting.
+	void Unregister();
+
+	virtual void NotifyUObjectCreated(const UObjectBase* Object, int32 Index) override;
+
+	virtual void OnUObjectArrayShutdown() override;
+
+	// Returns the number of objects created while registered.
+	FORCEINLINE int32 GetCount() const { return Count.GetValue(); }
+
+protected:
+
+	// The number of objects created while registered.
+	FThreadSafeCounter Count;
+
+	// Whether this is listening to the global object array.
+	bool bRegistered = false;
+};
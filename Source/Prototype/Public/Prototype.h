@@ -2,4 +2,19 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Runtime/Launch/Resources/Version.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogColumns, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("Columns"), STATGROUP_Columns, STATCAT_Advanced);
+
+// Unreal Insights counters arrived in 4.25; before that the counts only show in stat Columns.
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
+#include "ProfilingDebugging/CountersTrace.h"
+#define COLUMNS_TRACE_DECLARE_INT_COUNTER(CounterName, CounterDisplayName) TRACE_DECLARE_INT_COUNTER(CounterName, CounterDisplayName)
+#define COLUMNS_TRACE_COUNTER_SET(CounterName, Value) TRACE_COUNTER_SET(CounterName, Value)
+#else
+#define COLUMNS_TRACE_DECLARE_INT_COUNTER(CounterName, CounterDisplayName)
+#define COLUMNS_TRACE_COUNTER_SET(CounterName, Value)
+#endif
@@ -2,9 +2,17 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "ColumnsGame.h"
+#include "ColumnsReplay.h"
+#include "ColumnsSnapshot.h"
+#include "ObjectCreateCounter.h"
 #include "GameFramework/GameModeBase.h"
 #include "PrototypeGameModeBase.generated.h"
 
+// Seconds the level is shown in the centred text after it starts in place.
+constexpr float LEVEL_STARTED_TEXT_SECONDS = 2.0f;
+
 UCLASS()
 class PROTOTYPE_API APrototypeGameModeBase : public AGameModeBase
 {
@@ -13,9 +21,41 @@ class PROTOTYPE_API APrototypeGameModeBase : public AGameModeBase
 
 public:
 
-	// Adds a number of jewels and calculates score adder.
+	// Adds a number of jewels and calculates score adder, as a cascade step is shown.
 	void AddToJewelsAndScore(const int32 jewels);
 
+	// Advance the game's falling trinity, recording its landing into the replay; returns true if it landed
+	// or the game ended.
+	bool AdvanceGame(int32 deltaMs);
+
+	// Advance to the next level in place, without reloading the map.
+	void AdvanceLevel();
+
+	// Apply a pawn input to the game's falling trinity, recording it into the replay if it changed anything;
+	// returns false if the trinity couldn't move.
+	bool ApplyInput(EColumnsInput input);
+
+	virtual void BeginPlay() override;
+
+	// Play the replay recorded so far on a new game and warn if it doesn't land every trinity where the game
+	// did, or doesn't reach the same score.
+	bool CheckReplay() const;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Returns how fast cascades animate; 1 for normal speed, 2 for twice as fast.
+	FORCEINLINE float GetCascadeAnimationRate() const { return CascadeAnimationRate; }
+
+	// Returns the game the pawn and board play and show.
+	FORCEINLINE const FColumnsGame& GetGame() const { return Game; }
+
+	// Returns the rules of the game being played on a board of the given size.
+	FColumnsGameSettings GetGameSettings(int32 numberOfColumns, int32 numberOfRows, int32 numberOfSymbols) const;
+
+	// Returns the seed for searching the placements of the game's falling trinity; the same for the same trinity
+	// of the same game.
+	uint32 GetSearchSeed() const;
+
 	// Returns the number of jewels for the current level.
 	FORCEINLINE int32 GetJewels() const { return Jewels; }
 
@@ -25,24 +65,144 @@ public:
 	// Returns the current level.
 	FORCEINLINE int32 GetLevel() const { return Level; }
 
+	// Returns true once the board has started the game.
+	FORCEINLINE bool IsGameStarted() const { return bGameStarted; }
+
+	// Returns true if each level is started by the blueprint reloading the map rather than in place.
+	FORCEINLINE bool IsReloadingEachLevel() const { return bReloadEachLevel; }
+
+	// Returns true if the board scrolls down as it's cleared instead of starting again each level.
+	FORCEINLINE bool IsEndless() const { return EndlessRows > 0; }
+
+	// Returns true if a cascade is shown settled as soon as the trinity lands, without animating its steps.
+	FORCEINLINE bool IsFastForwardingCascades() const { return bFastForwardCascades; }
+
+	// Returns how many times faster than real time the game runs.
+	FORCEINLINE int32 GetTurboMultiplier() const { return FMath::Max(1, TurboMultiplier); }
+
+	// Seed the random numbers; use ?Seed=n on the map url to replay a particular game, ?Endless=rows for an
+	// endless board, ?Resume to carry on from the checkpoint save, ?FastForward to skip cascade animations,
+	// and ?Turbo=n to run the game n times faster than real time.
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+	// Step back a number of moves: restore the game, level and score, here and in the game instance, and drop
+	// the replay events since, for the board and pawn to show; false if it doesn't go back that far.
+	bool Rewind(int32 moves);
+
+	// Start the game on a board of the given size, begin recording its replay, and have the pawn show it.
+	void StartGame(int32 numberOfColumns, int32 numberOfRows, int32 numberOfSymbols);
+
+	// Called as the game starts and once each move has settled, with the trinity at the top of the board: keep
+	// a snapshot of the game to rewind to, and write it as the checkpoint save on a worker, or once the save
+	// being written is done.
+	void TakeSnapshot();
+
+	// Called as each trinity spawns; updates the stats of the move that just finished.
+	void UpdateMoveStats();
+
 	// Blueprint event to trigger ending the game.
 	UFUNCTION(BlueprintImplementableEvent, Category = "GameMode")
 	void TriggerEndGame();
 
-	// Blueprint even to trigger advancing to the next level.
+	// Event after the next level has started in place, to update the display; shows the level in the centred
+	// text for a moment unless a blueprint overrides it.
+	UFUNCTION(BlueprintNativeEvent, Category = "GameMode")
+	void TriggerLevelStarted();
+
+	// Blueprint even to trigger advancing to the next level, when reloading the map each level.
 	UFUNCTION(BlueprintImplementableEvent, Category = "GameMode")
 	void TriggerNextLevel();
 
 protected:
 
+	// Clear the level shown in the centred text when a level started, unless the game has ended since.
+	void ClearLevelStartedText();
+
+	// Start filling the game's next level board on a worker, while the current level is played.
+	void PrefetchNextBoard();
+
+	// Restore the game, level and score of a snapshot, and drop the replay events after it; false if the
+	// snapshot was taken on another size of board.
+	bool RestoreSnapshotState(const FColumnsSnapshot& snapshot);
+
+	// Put the game back as the checkpoint save has it for the board and pawn to show; called on the first
+	// tick, once they've begun play.
+	void ResumeCheckpoint();
+
+	// Start writing the pending checkpoint on a worker, unless the last one is still being written.
+	void SavePendingCheckpoint();
+
+	// Show the level in the centred text, which the map reload used to do through the blueprint.
+	virtual void TriggerLevelStarted_Implementation();
+
+	// Copy the level and score to the game instance, which carries them over a map reload.
+	void UpdateGameInstance();
+
+	// Whether to show each cascade settled at once, skipping the highlight and fall of every step.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GameMode")
+	bool bFastForwardCascades = false;
+
+	// Whether a checkpoint is waiting for the last save to finish before it's written.
+	bool bCheckpointPending = false;
+
+	// Whether the board has started the game.
+	bool bGameStarted = false;
+
+	// Whether to resume from the checkpoint save once play begins; the save isn't overwritten until then.
+	bool bResumeCheckpoint = false;
+
+	// Whether to write the game to Saved/SaveGames/Columns.checkpoint after every move, to resume with ?Resume.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GameMode")
+	bool bSaveCheckpoints = true;
+
+	// Whether to save a replay of every game to Saved/Replays.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GameMode")
+	bool bRecordReplays = true;
+
+	// Whether to hand each level change to the blueprint to reload the map, carrying the level and score in
+	// the game instance, instead of refilling the board in place.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GameMode")
+	bool bReloadEachLevel = false;
+
+	// How fast cascades animate; higher compresses the highlight and fall of every step.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GameMode", meta = (ClampMin = "0.1"))
+	float CascadeAnimationRate = 1.0f;
+
 	// The text displayed on the center of the screen (to indicate game over, next level).
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "GameMode")
 	FText CenteredText;
 
+	// Clears the centred text a while after a level starts.
+	FTimerHandle CenteredTextTimer;
+
+	// The checkpoint save being written on a worker; the next waits in pending checkpoint until it's done, so
+	// saves land in order.
+	TFuture<bool> CheckpointSave;
+
+	// The height in rows of an endless board; 0 to start a new board each level.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GameMode")
+	int32 EndlessRows = 0;
+
+	// Counts the UObjects created during play.
+	FObjectCreateCounter ObjectCreateCounter;
+
+	// The object count when the last move started; INDEX_NONE before the first move.
+	int32 ObjectCountAtMoveStart = INDEX_NONE;
+
+	// The game played by the pawn and shown by the board, with the seeded random numbers; the level, jewels
+	// and score below follow it as its cascades are shown.
+	FColumnsGame Game;
+
 	// The number of collected jewels in the current level.
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "GameMode")
 	int32 Jewels = 0;
 
+	// The game's next level board, filled on a worker and lent to the game once it's done.
+	TSharedPtr<FColumnsNextBoard, ESPMode::ThreadSafe> NextBoard;
+
+	// Filling the next board; the game isn't lent it until this is done.
+	TFuture<void> NextBoardFill;
+
 	// The number of jewels required to advance level.
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "GameMode")
 	int32 JewelsRequired = 20;
@@ -51,7 +211,35 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "GameMode")
 	int32 Level = 1;
 
+	// The replay being recorded.
+	FColumnsReplay Replay;
+
+	// The newest snapshot to write as the checkpoint save, once the one being written is done.
+	FColumnsSnapshot PendingCheckpoint;
+
+	// The game read from the checkpoint save, to resume from.
+	FColumnsSnapshot ResumeSnapshot;
+
+	// The moves that can be stepped back through; 0 to not keep snapshots.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GameMode")
+	int32 RewindMoves = 32;
+
 	// The total score.
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "GameMode")
 	int32 Score;
+
+	// The score carried over a map reload when the game started, that the game's own score adds to.
+	int32 ScoreAtStart = 0;
+
+	// The seed for the game's random numbers; 0 picks a new seed every game.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GameMode")
+	int32 Seed = 0;
+
+	// A snapshot of the game at the start of each of the last few moves, newest first.
+	FColumnsSnapshotRing Snapshots;
+
+	// How many times faster than real time the game runs: the pawn takes this many simulation steps for each
+	// step's worth of frame time, and cascades animate this much faster. For soak tests in the game build.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GameMode", meta = (ClampMin = "1", ClampMax = "10000"))
+	int32 TurboMultiplier = 1;
 };
@@ -3,20 +3,35 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Pawn.h"
+#include "Async/Future.h"
+#include "HAL/ThreadSafeBool.h"
+#include "ColumnsGame.h"
+#include "ColumnsSearch.h"
 #include "GameBoardActor.h"
+#include "MeshComponentPool.h"
 #include "PrototypePawn.generated.h"
 
-// Set the number of symbols in the pawn.
-constexpr int32 PAWN_SIZE = 3;
+// The length of a simulation step, in the milliseconds the game and replays are timed in.
+constexpr int32 PAWN_STEP_MS = 4;
 
-// Sets the pawn speed when transitioning between locations.
-constexpr int32 PAWN_SPEED_PIXELS_PER_SECOND = 1200;
+// The length of a simulation step in seconds, derived from the milliseconds.
+constexpr float PAWN_STEP_SECONDS = PAWN_STEP_MS / 1000.0f;
 
-// Sets the pixels per second that gravity pulls down the symbol (adjusted by level)
-constexpr int32 PAWN_GRAVITY_PIXELS_PER_SECOND = 90;
+// The most frame time the simulation catches up on in one frame, at normal speed.
+constexpr int32 PAWN_MAX_CATCH_UP_MS = 250;
 
-// how many pixels per second to add to gravity per level
-constexpr float PAWN_GRAVITY_LEVEL_SCALE = 20;
+// Where the hint search would put the falling trinity, ready to be shown.
+struct FColumnsHint
+{
+	// The column and shuffles the search chose.
+	FColumnsPlacement Placement;
+
+	// The row the top symbol lands in.
+	int32 Row = 0;
+
+	// The trinity's symbols top first, once shuffled.
+	TArray<int32> SymbolIndicies;
+};
 
 UCLASS()
 class PROTOTYPE_API APrototypePawn : public APawn
@@ -29,6 +44,13 @@ public:
 	APrototypePawn();
 
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
+
+	// Show the game as it stands, once it's started or restored from a snapshot: the board, and the trinity
+	// where the game has it, ready for input.
+	void ShowGame();
+
+	// Run the simulation steps the frame's time makes up, the game mode's turbo multiplier times over, and
+	// draw the trinity interpolated between the last two.
 	virtual void Tick(float DeltaTime) override;
 
 	// Called by the game board after animation completes to end the trigger next move process.
@@ -38,9 +60,33 @@ protected:
 
 	virtual void BeginPlay() override;
 
-	// Construct the stacked symbols that represent the pawn at the location.
+	// Apply an input to the game's falling trinity, and show the trinity's symbols again after a shuffle.
+	void ApplyInput(EColumnsInput input);
+
+	// Start the move search for the trinity, then press the inputs that take it to the chosen placement.
+	void AutoPlayTick();
+
+	// Stop the hint search under way and hide the hint.
+	void CancelHint();
+
+	// Construct the stacked symbols that represent the game's falling and next trinities, and take down the
+	// last trinity's hint.
 	void ConstructTrinity();
 
+	// Advance the game one fixed step, after the move search's input, and move the trinity's drawn location
+	// after the game's: straight down with the fall, and sliding across to a new column.
+	void StepSimulation();
+
+	// Cancel the hint search under way and start one for the trinity where it is, on a copy of the board.
+	void StartHintSearch();
+
+	// Show or hide the hint.
+	void ToggleHint();
+
+	// Start the hint search again if the board changed under it, and show its result once it's done; never
+	// waits on the search.
+	void UpdateHint();
+
 	// Reorder the symbols by moving them down (last symbol goes to top).
 	void ShuffleDown();
 	
@@ -59,40 +105,100 @@ protected:
 	// Attempt to move the trinity right.
 	void MoveRight();
 
-	// A collision downward occurred; trigger next move preparation. Defer to game board to allow collapsing animation.
+	// Step back to the start of the last trinity's move, if the game mode kept a snapshot of it.
+	void RewindMove();
+
+	// Show the game's falling trinity symbols on the trinity's components, as a shuffle leaves them.
+	void ShowTrinitySymbols();
+
+	// The trinity landed in the game; trigger next move preparation. Defer to game board to allow collapsing animation.
 	void TriggerNextMoveStart();
 
+	// Whether the move search plays instead of the player; also turned on by -autoplay on the command line.
+	UPROPERTY(EditAnywhere, Category = "PrototypePawn")
+	bool bAutoPlay = false;
+
+	// Seconds the move search may take for each trinity; it runs on worker threads, not in the frame.
+	UPROPERTY(EditAnywhere, Category = "PrototypePawn")
+	float AutoPlayBudgetSeconds = 0.05f;
+
+	// Pieces the move search looks ahead, counting the falling trinity.
+	UPROPERTY(EditAnywhere, Category = "PrototypePawn")
+	int32 AutoPlayDepth = 3;
+
+	// The move search for the current trinity, once started.
+	TFuture<FColumnsSearchResult> AutoPlaySearch;
+
+	// Values of positions the move and hint searches have already seen, kept from one trinity to the next.
+	TSharedPtr<FColumnsTranspositionTable, ESPMode::ThreadSafe> AutoPlayTable;
+
+	// Shuffles still to press before moving to the chosen column.
+	int32 AutoPlayShuffleDownsLeft = 0;
+
+	// The placement chosen for the current trinity, once the search is done.
+	FColumnsPlacement AutoPlayTarget;
+
+	// Whether the search is done and the target placement is set.
+	bool bAutoPlayTargetSet = false;
+
+	// Whether the best placement of the trinity is shown, as ghost symbols where it would land.
+	UPROPERTY(EditAnywhere, Category = "PrototypePawn")
+	bool bShowHint = false;
+
+	// Seconds the hint search may take for each trinity.
+	UPROPERTY(EditAnywhere, Category = "PrototypePawn")
+	float HintBudgetSeconds = 0.2f;
+
+	// Pieces the hint search looks ahead, counting the falling trinity.
+	UPROPERTY(EditAnywhere, Category = "PrototypePawn")
+	int32 HintDepth = 3;
+
+	// The material of the ghost symbols; the symbol meshes' own material if not set.
+	UPROPERTY(EditAnywhere, Category = "PrototypePawn")
+	class UMaterialInterface* HintMaterial = nullptr;
+
+	// The hash of the board the hint search was started on.
+	uint64 HintBoardHash = 0;
+
+	// Set to stop the hint search under way; each search has its own, so a stopped one can finish in peace.
+	TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> HintCancel;
+
+	// The components that show the ghost symbols, apart from the trinity's so their material stays put.
+	FMeshComponentPool HintComponentPool{ TEXT("HintMeshComponent") };
+
+	// The hint search for the current trinity, once started.
+	TFuture<FColumnsHint> HintSearch;
+
+	// Whether the hint search's result is shown.
+	bool bHintShown = false;
+
+	// The components that show the current and next symbols, reused for every trinity.
+	FMeshComponentPool MeshComponentPool{ TEXT("SymbolMeshComponent") };
+
 	// Components that make up the pawn visual.
 	TArray<UStaticMeshComponent*> CurrentPawnStaticMeshComponents;
 
-	// Symbol indicies that make up the pawn.
+	// Symbol indicies the trinity is drawn with, the game's; kept as it lands, for the board to show.
 	TArray<int32> CurrentSymbolIndicies;
 
-	// variables use to smoothly move between locations
-	int32 DesiredLocationX = 0;
-	int32 DesiredLocationY = -PAWN_SIZE;
-
 	// The game board instance that the pawn moves across.
 	UPROPERTY(EditAnywhere, Category="PrototypePawn")
 	AGameBoardActor *GameBoardActor;
 
-	// The gravity used to pull down the symbols during play. Scaled down based on level.
-	float GravityPixelsPerSecond = PAWN_GRAVITY_PIXELS_PER_SECOND;
-
-	// whether the move down key is being held to trigger moving down more quickly
-	bool MoveDownKeyHeldDown = false;
-
 	// The components that represent the next set of symbols.
 	TArray<UStaticMeshComponent*> NextPawnStaticMeshComponents;
 
-	// Symbol indicies that make up the next set of symbols.
-	TArray<int32> NextSymbolIndicies;
+	// The cycle count when the last trinity landed, until its cascade settles; 0 otherwise.
+	uint32 LandCycles = 0;
 
-	// Column index where the top symbol is located.
-	int32 LocationX = 0;
+	// Where the last simulation step left the top symbol, and where the step before it did; the trinity is
+	// drawn between the two.
+	FVector PreviousSimulatedLocation = FVector::ZeroVector;
+	FVector SimulatedLocation = FVector::ZeroVector;
 
-	// Row index where the top symbol is located.
-	int32 LocationY = -PAWN_SIZE;
+	// Frame time not simulated yet, in microseconds so it adds up exactly; less than a step once a frame's
+	// steps have run, unless a landing handed over to the board with steps left, which the next trinity takes.
+	int64 SimulationMicroseconds = 0;
 
 	// Root scene component so that this pawn is visible in level.
 	USceneComponent* RootSceneComponent;